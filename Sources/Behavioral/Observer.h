@@ -10,6 +10,9 @@
 
 #pragma once
 
+#include <iostream>
+#include <list>
+
 namespace Observer
 {
 
@@ -0,0 +1,203 @@
+﻿// Small timing helpers shared by the pattern benchmarks.
+// Every benchmark runs a body for a fixed number of iterations (optionally on several threads at once)
+// and reports throughput, so the numbers of different implementations can be compared side by side.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Benchmark
+{
+
+struct Result
+{
+	std::string Name;
+	int Threads = 1;
+	std::size_t Operations = 0;
+	double Seconds = 0.0;
+
+	double OperationsPerSecond() const { return Seconds > 0.0 ? Operations / Seconds : 0.0; }
+	double NanosecondsPerOperation() const { return Operations > 0 ? Seconds * 1e9 / Operations : 0.0; }
+};
+
+// Keeps the compiler from optimizing away a value that is computed only for the benchmark
+template<typename T>
+inline void DoNotOptimize(const T& Value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "g"(&Value) : "memory");
+#else
+	static const void* volatile Sink;
+	Sink = &Value;
+#endif
+}
+
+// Every reported result, in the order the benchmarks ran; WriteJson dumps them
+inline std::vector<Result>& Results()
+{
+	static std::vector<Result> AllResults;
+	return AllResults;
+}
+
+inline void Report(const Result& InResult)
+{
+	Results().push_back(InResult);
+
+	const std::ios_base::fmtflags Flags = std::cout.flags();
+	const std::streamsize Precision = std::cout.precision();
+	std::cout << std::left << std::setw(56) << InResult.Name
+		<< " threads: " << std::setw(3) << InResult.Threads
+		<< std::right << std::fixed << std::setprecision(1)
+		<< std::setw(14) << InResult.OperationsPerSecond() / 1e6 << " Mops/s"
+		<< std::setw(10) << InResult.NanosecondsPerOperation() << " ns/op"
+		<< std::endl;
+	std::cout.flags(Flags);
+	std::cout.precision(Precision);
+}
+
+// Runs Body(Iterations) once on the calling thread, for a body that spreads its work over Threads threads itself
+template<typename Func>
+Result Run(const std::string& Name, int Threads, std::size_t Iterations, Func&& Body)
+{
+	const auto Start = std::chrono::steady_clock::now();
+	Body(Iterations);
+	const auto Finish = std::chrono::steady_clock::now();
+
+	Result NewResult;
+	NewResult.Name = Name;
+	NewResult.Threads = Threads;
+	NewResult.Operations = Iterations;
+	NewResult.Seconds = std::chrono::duration<double>(Finish - Start).count();
+	Report(NewResult);
+	return NewResult;
+}
+
+// Runs Body(Iterations) once on the calling thread
+template<typename Func>
+Result Run(const std::string& Name, std::size_t Iterations, Func&& Body)
+{
+	return Run(Name, 1, Iterations, std::forward<Func>(Body));
+}
+
+// Like Run, but calls Setup(Iterations) first without timing it, e.g. to build the objects Body destroys
+template<typename SetupFunc, typename Func>
+Result RunWithSetup(const std::string& Name, std::size_t Iterations, SetupFunc&& Setup, Func&& Body)
+{
+	Setup(Iterations);
+	return Run(Name, Iterations, std::forward<Func>(Body));
+}
+
+// Runs Body(ThreadIndex, IterationsPerThread) on Threads threads released at the same moment
+template<typename Func>
+Result RunParallel(const std::string& Name, int Threads, std::size_t IterationsPerThread, Func&& Body)
+{
+	std::atomic<int> ReadyThreads(0);
+	std::atomic<bool> Go(false);
+
+	std::vector<std::thread> Workers;
+	Workers.reserve(Threads);
+	for (int ThreadIndex = 0; ThreadIndex < Threads; ++ThreadIndex)
+	{
+		Workers.emplace_back([&, ThreadIndex]()
+			{
+				ReadyThreads.fetch_add(1);
+				while (!Go.load(std::memory_order_acquire))
+				{
+					std::this_thread::yield();
+				}
+				Body(ThreadIndex, IterationsPerThread);
+			});
+	}
+
+	while (ReadyThreads.load() != Threads)
+	{
+		std::this_thread::yield();
+	}
+
+	const auto Start = std::chrono::steady_clock::now();
+	Go.store(true, std::memory_order_release);
+	for (std::thread& Worker : Workers)
+	{
+		Worker.join();
+	}
+	const auto Finish = std::chrono::steady_clock::now();
+
+	Result NewResult;
+	NewResult.Name = Name;
+	NewResult.Threads = Threads;
+	NewResult.Operations = IterationsPerThread * Threads;
+	NewResult.Seconds = std::chrono::duration<double>(Finish - Start).count();
+	Report(NewResult);
+	return NewResult;
+}
+
+// 1, 2, 4, ... up to the number of hardware threads (always including the maximum itself)
+inline std::vector<int> ThreadCounts()
+{
+	const int MaxThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+	std::vector<int> Counts;
+	for (int Count = 1; Count < MaxThreads; Count *= 2)
+	{
+		Counts.push_back(Count);
+	}
+	Counts.push_back(MaxThreads);
+	return Counts;
+}
+
+inline std::string EscapeJson(const std::string& Text)
+{
+	std::string Escaped;
+	for (char Character : Text)
+	{
+		switch (Character)
+		{
+		case '"': Escaped += "\\\""; break;
+		case '\\': Escaped += "\\\\"; break;
+		case '\n': Escaped += "\\n"; break;
+		case '\t': Escaped += "\\t"; break;
+		default: Escaped += Character; break;
+		}
+	}
+	return Escaped;
+}
+
+// Writes Results() as one JSON document. Context holds "key": "value" pairs describing the run
+// (commit, compiler, build type) so results of different commits can be told apart.
+inline void WriteJson(std::ostream& Out, const std::vector<std::pair<std::string, std::string>>& Context)
+{
+	Out << "{\n  \"context\": {";
+	for (std::size_t i = 0; i < Context.size(); ++i)
+	{
+		Out << (i == 0 ? "\n" : ",\n") << "    \"" << EscapeJson(Context[i].first) << "\": \"" << EscapeJson(Context[i].second) << "\"";
+	}
+	Out << "\n  },\n  \"benchmarks\": [";
+
+	const std::vector<Result>& AllResults = Results();
+	for (std::size_t i = 0; i < AllResults.size(); ++i)
+	{
+		const Result& Current = AllResults[i];
+		Out << (i == 0 ? "\n" : ",\n")
+			<< "    {\"name\": \"" << EscapeJson(Current.Name) << "\""
+			<< ", \"threads\": " << Current.Threads
+			<< ", \"operations\": " << Current.Operations
+			<< std::scientific << std::setprecision(9)
+			<< ", \"seconds\": " << Current.Seconds
+			<< ", \"operations_per_second\": " << Current.OperationsPerSecond()
+			<< ", \"nanoseconds_per_operation\": " << Current.NanosecondsPerOperation()
+			<< std::defaultfloat << "}";
+	}
+	Out << "\n  ]\n}\n";
+}
+
+} // namespace Benchmark
@@ -0,0 +1,104 @@
+﻿// Benchmarks.cpp : Entry point of the benchmark executable.
+// Runs every pattern benchmark, prints a table and, given --json <file>, writes the results as JSON
+// so runs of different commits can be compared.
+
+#include "Patterns.h"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Creational/AbstractFactory.h"
+#include "Creational/Builder.h"
+#include "Creational/FactoryMethod.h"
+#include "Creational/Singleton.h"
+#include "SmartPointers/SmartPointers.h"
+
+#ifndef PATTERNS_BUILD_TYPE
+#define PATTERNS_BUILD_TYPE "unknown"
+#endif
+
+namespace
+{
+std::string CompilerName()
+{
+#if defined(__clang__)
+	return "clang " __clang_version__;
+#elif defined(__GNUC__)
+	return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+	return "msvc " + std::to_string(_MSC_VER);
+#else
+	return "unknown";
+#endif
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	std::string jsonPath;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string argument = argv[i];
+		if (argument == "--json" && i + 1 < argc)
+		{
+			jsonPath = argv[++i];
+		}
+		else
+		{
+			std::cerr << "Usage: " << argv[0] << " [--json <file>]" << std::endl;
+			return 1;
+		}
+	}
+
+	std::cout << "\n=== Factory Method Pattern ===\n";
+	FactoryMethod::BenchmarkVehicleFactories();
+	FactoryMethod::BenchmarkStaticVehicleFactory();
+	FactoryMethod::BenchmarkVehicleBatches();
+	FactoryMethod::BenchmarkVehicleNameLookup();
+
+	std::cout << "\n=== Abstract Factory Pattern ===\n";
+	AbstractFactory::BenchmarkWidgetFactories();
+	AbstractFactory::BenchmarkDrawList();
+	AbstractFactory::BenchmarkStaticGUIFactory();
+
+	std::cout << "\n=== Builder Pattern ===\n";
+	Builder::BenchmarkPCBuilders();
+	Builder::BenchmarkBuildMany();
+
+	std::cout << "\n=== Singleton Pattern ===\n";
+	Singleton::BenchmarkSingletonAccess();
+	Singleton::BenchmarkLogger();
+	Singleton::BenchmarkFormattedLogging();
+	Singleton::BenchmarkFileSinks();
+
+	std::cout << "\n=== Custom Smart Pointers ===\n";
+	SmartPointers::BenchmarkSmartPointers();
+
+	if (!jsonPath.empty())
+	{
+		std::ofstream jsonFile(jsonPath);
+		if (!jsonFile)
+		{
+			std::cerr << "Cannot open " << jsonPath << std::endl;
+			return 1;
+		}
+
+		const std::vector<std::pair<std::string, std::string>> context = {
+			{ "version", std::to_string(PATTERNS_VERSION_MAJOR) + "." + std::to_string(PATTERNS_VERSION_MINOR) + "." + std::to_string(PATTERNS_VERSION_PATCH) },
+			{ "commit", GIT_COMMIT_HASH },
+			{ "commit_time", GIT_COMMIT_TIME },
+			{ "compiler", CompilerName() },
+			{ "build_type", PATTERNS_BUILD_TYPE },
+			{ "hardware_threads", std::to_string(std::thread::hardware_concurrency()) },
+			{ "smart_pointers_statistics", SmartPointers::Statistics::Enabled ? "on" : "off" },
+		};
+		Benchmark::WriteJson(jsonFile, context);
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -15,9 +15,23 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
 #include <iostream>
 #include <memory>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../Benchmark.h"
 
 namespace AbstractFactory
 {
@@ -36,40 +50,122 @@ public:
     virtual void Paint() const = 0;
 };
 
-class WindowsButton : public Button
+class WindowsButton final : public Button
 {
 public:
+    static constexpr std::string_view PaintText = "Rendering a button in Windows style.\n";
+
     void Paint() const override
     {
-        std::cout << "Rendering a button in Windows style.\n";
+        std::cout << PaintText;
     }
 };
 
-class WindowsCheckbox : public Checkbox
+class WindowsCheckbox final : public Checkbox
 {
 public:
+    static constexpr std::string_view PaintText = "Rendering a checkbox in Windows style.\n";
+
     void Paint() const override
     {
-        std::cout << "Rendering a checkbox in Windows style.\n";
+        std::cout << PaintText;
     }
 };
 
-class MacOSButton : public Button
+class MacOSButton final : public Button
 {
 public:
+    static constexpr std::string_view PaintText = "Rendering a button in MacOS style.\n";
+
     void Paint() const override
     {
-        std::cout << "Rendering a button in MacOS style.\n";
+        std::cout << PaintText;
     }
 };
 
-class MacOSCheckbox : public Checkbox
+class MacOSCheckbox final : public Checkbox
 {
 public:
+    static constexpr std::string_view PaintText = "Rendering a checkbox in MacOS style.\n";
+
     void Paint() const override
     {
-        std::cout << "Rendering a checkbox in MacOS style.\n";
+        std::cout << PaintText;
+    }
+};
+
+// Widgets queued for painting, sorted by kind: every kind is painted in one pass, a few kilobytes per
+// write, instead of one virtual Paint call and one stream write per widget. Widgets hold no state, so the
+// batch of a kind is its paint text and a count; per-widget attributes would become arrays next to them.
+class DrawList
+{
+public:
+    DrawList(std::string_view ButtonText, std::string_view CheckboxText)
+        : Batches{ { ButtonText, 0 }, { CheckboxText, 0 } }
+    {
     }
+
+    void AddButton() { ++Batches[ButtonBatch].Count; }
+    void AddCheckbox() { ++Batches[CheckboxBatch].Count; }
+
+    std::size_t GetButtonCount() const { return Batches[ButtonBatch].Count; }
+    std::size_t GetCheckboxCount() const { return Batches[CheckboxBatch].Count; }
+
+    // Paints all buttons, then all checkboxes. The list keeps its widgets until Clear.
+    void Paint(std::ostream& Out = std::cout)
+    {
+        for (const Batch& batch : Batches)
+        {
+            if (batch.Count == 0)
+            {
+                continue;
+            }
+
+            // A fixed chunk holding as many copies of the text as fit, written as often as needed
+            char chunk[ChunkBytes];
+            const std::size_t copiesPerChunk = ChunkBytes / std::max<std::size_t>(batch.Text.size(), 1);
+            if (copiesPerChunk == 0)
+            {
+                for (std::size_t i = 0; i < batch.Count; ++i)
+                {
+                    Out.write(batch.Text.data(), static_cast<std::streamsize>(batch.Text.size()));
+                }
+                continue;
+            }
+
+            const std::size_t copies = std::min(copiesPerChunk, batch.Count);
+            for (std::size_t i = 0; i < copies; ++i)
+            {
+                std::memcpy(chunk + i * batch.Text.size(), batch.Text.data(), batch.Text.size());
+            }
+            for (std::size_t written = 0; written < batch.Count; written += copies)
+            {
+                const std::size_t count = std::min(copies, batch.Count - written);
+                Out.write(chunk, static_cast<std::streamsize>(count * batch.Text.size()));
+            }
+        }
+    }
+
+    void Clear()
+    {
+        for (Batch& batch : Batches)
+        {
+            batch.Count = 0;
+        }
+    }
+
+private:
+    enum { ButtonBatch, CheckboxBatch, BatchCount };
+
+    static constexpr std::size_t ChunkBytes = 4096;
+
+    struct Batch
+    {
+        std::string_view Text;
+        std::size_t Count;
+    };
+
+    Batch Batches[BatchCount];
 };
 
 class GUIFactory
@@ -78,6 +174,13 @@ public:
     virtual ~GUIFactory() = default;
     virtual std::shared_ptr<Button> CreateButton() const = 0;
     virtual std::shared_ptr<Checkbox> CreateCheckbox() const = 0;
+
+    // An empty draw list for the widgets of this family. Not pure so that factories written before draw
+    // lists keep compiling; they have no paint text to batch and keep painting through RenderUI.
+    virtual DrawList CreateDrawList() const
+    {
+        throw std::logic_error("This GUI factory does not support draw lists");
+    }
 };
 
 class WindowsFactory : public GUIFactory
@@ -92,6 +195,11 @@ public:
     {
         return std::make_shared<WindowsCheckbox>();
     }
+
+    DrawList CreateDrawList() const override
+    {
+        return DrawList(WindowsButton::PaintText, WindowsCheckbox::PaintText);
+    }
 };
 
 class MacOSFactory : public GUIFactory
@@ -106,8 +214,134 @@ public:
     {
         return std::make_shared<MacOSCheckbox>();
     }
+
+    DrawList CreateDrawList() const override
+    {
+        return DrawList(MacOSButton::PaintText, MacOSCheckbox::PaintText);
+    }
 };
 
+// Widgets hold no state, so one instance per family can be shared by every caller (flyweight).
+// Creating a widget only copies a shared_ptr to it, nothing is allocated.
+template<typename ButtonType, typename CheckboxType>
+class CachedGUIFactory : public GUIFactory
+{
+public:
+    std::shared_ptr<Button> CreateButton() const override
+    {
+        static const std::shared_ptr<Button> SharedButton = std::make_shared<ButtonType>();
+        return SharedButton;
+    }
+
+    std::shared_ptr<Checkbox> CreateCheckbox() const override
+    {
+        static const std::shared_ptr<Checkbox> SharedCheckbox = std::make_shared<CheckboxType>();
+        return SharedCheckbox;
+    }
+
+    DrawList CreateDrawList() const override
+    {
+        return DrawList(ButtonType::PaintText, CheckboxType::PaintText);
+    }
+};
+
+using CachedWindowsFactory = CachedGUIFactory<WindowsButton, WindowsCheckbox>;
+using CachedMacOSFactory = CachedGUIFactory<MacOSButton, MacOSCheckbox>;
+
+// Bump allocator for objects that live for one frame. Memory comes in fixed size blocks that are kept
+// for the next frame, Reset rewinds to the first block in O(1) without running destructors, so it must
+// only hold objects whose destructors have no side effects.
+class FrameArena
+{
+public:
+    explicit FrameArena(std::size_t InBlockSize = 4096)
+        : BlockSize(InBlockSize)
+    {
+    }
+
+    FrameArena(const FrameArena& other) = delete;
+    FrameArena& operator=(const FrameArena& other) = delete;
+
+    void* Allocate(std::size_t Size, std::size_t Alignment)
+    {
+        std::size_t offset = (Offset + Alignment - 1) & ~(Alignment - 1);
+        if (CurrentBlock == Blocks.size() || offset + Size > BlockSize)
+        {
+            if (Size > BlockSize)
+            {
+                throw std::bad_alloc();
+            }
+            if (CurrentBlock != Blocks.size())
+            {
+                ++CurrentBlock;
+            }
+            if (CurrentBlock == Blocks.size())
+            {
+                Blocks.push_back(std::make_unique<std::byte[]>(BlockSize));
+            }
+            offset = 0;
+        }
+        Offset = offset + Size;
+        return Blocks[CurrentBlock].get() + offset;
+    }
+
+    template<typename T, typename... Args>
+    T* Create(Args&&... Arguments)
+    {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "FrameArena blocks are only aligned to max_align_t");
+        return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(Arguments)...);
+    }
+
+    // Every object created since the last Reset is gone afterwards
+    void Reset()
+    {
+        CurrentBlock = 0;
+        Offset = 0;
+    }
+
+    std::size_t GetBlockCount() const { return Blocks.size(); }
+
+private:
+    std::size_t BlockSize;
+    std::vector<std::unique_ptr<std::byte[]>> Blocks;
+    std::size_t CurrentBlock = 0;
+    std::size_t Offset = 0;
+};
+
+// Allocates the widgets of one frame from a FrameArena. The arena owns them: the factory hands out
+// references, which stay valid until the arena is reset. Not a GUIFactory, whose shared_ptr products
+// would promise an ownership the caller does not get.
+template<typename ButtonType, typename CheckboxType>
+class ArenaGUIFactory
+{
+public:
+    explicit ArenaGUIFactory(FrameArena& InArena)
+        : Arena(&InArena)
+    {
+    }
+
+    ButtonType& CreateButton() const
+    {
+        return *Arena->Create<ButtonType>();
+    }
+
+    CheckboxType& CreateCheckbox() const
+    {
+        return *Arena->Create<CheckboxType>();
+    }
+
+    DrawList CreateDrawList() const
+    {
+        return DrawList(ButtonType::PaintText, CheckboxType::PaintText);
+    }
+
+private:
+    FrameArena* Arena;
+};
+
+using ArenaWindowsFactory = ArenaGUIFactory<WindowsButton, WindowsCheckbox>;
+using ArenaMacOSFactory = ArenaGUIFactory<MacOSButton, MacOSCheckbox>;
+
 void RenderUI(const GUIFactory& factory)
 {
     auto button = factory.CreateButton();
@@ -117,6 +351,64 @@ void RenderUI(const GUIFactory& factory)
     checkbox->Paint();
 }
 
+// The widgets stay in the arena until its next reset
+template<typename ButtonType, typename CheckboxType>
+void RenderUI(const ArenaGUIFactory<ButtonType, CheckboxType>& factory)
+{
+    const Button& button = factory.CreateButton();
+    const Checkbox& checkbox = factory.CreateCheckbox();
+
+    button.Paint();
+    checkbox.Paint();
+}
+
+// Product family selected at compile time, for builds that only ever target one platform.
+// The runtime GUIFactory stays for code that picks the family while running, e.g. plugins.
+struct WindowsTraits
+{
+    using ButtonType = WindowsButton;
+    using CheckboxType = WindowsCheckbox;
+};
+
+struct MacOSTraits
+{
+    using ButtonType = MacOSButton;
+    using CheckboxType = MacOSCheckbox;
+};
+
+// Creates the concrete, final products of one family by value: no allocation, and Paint is
+// called on a known type so it is not dispatched virtually and can be inlined
+template<typename Traits>
+class StaticGUIFactory
+{
+public:
+    using ButtonType = typename Traits::ButtonType;
+    using CheckboxType = typename Traits::CheckboxType;
+
+    static_assert(std::is_final_v<ButtonType> && std::is_final_v<CheckboxType>, "Products must be final to be called without virtual dispatch");
+
+    ButtonType CreateButton() const { return ButtonType(); }
+    CheckboxType CreateCheckbox() const { return CheckboxType(); }
+    DrawList CreateDrawList() const { return DrawList(ButtonType::PaintText, CheckboxType::PaintText); }
+};
+
+template<typename Traits>
+void RenderUI(const StaticGUIFactory<Traits>& factory)
+{
+    const auto button = factory.CreateButton();
+    const auto checkbox = factory.CreateCheckbox();
+
+    button.Paint();
+    checkbox.Paint();
+}
+
+// Batched RenderUI: queues the widgets, List.Paint draws them
+void RenderUI(DrawList& List)
+{
+    List.AddButton();
+    List.AddCheckbox();
+}
+
 
 void TestAbstractFactory()
 {
@@ -129,4 +421,279 @@ void TestAbstractFactory()
     RenderUI(macFactory);
 }
 
+void TestWidgetFactories()
+{
+    // Flyweights: the same widget every time, shared by everyone holding it
+    CachedWindowsFactory cachedFactory;
+    std::shared_ptr<Button> firstButton = cachedFactory.CreateButton();
+    std::shared_ptr<Button> secondButton = cachedFactory.CreateButton();
+    assert(firstButton.get() == secondButton.get());
+    assert(firstButton.use_count() == 3);
+    assert(dynamic_cast<WindowsButton*>(firstButton.get()) != nullptr);
+    assert(dynamic_cast<MacOSCheckbox*>(CachedMacOSFactory().CreateCheckbox().get()) != nullptr);
+    assert(CachedMacOSFactory().CreateButton().get() != firstButton.get());
+
+    // Arena: distinct widgets per frame, the memory is reused after a reset
+    FrameArena arena(256);
+    ArenaMacOSFactory arenaFactory(arena);
+    MacOSButton& frameButton = arenaFactory.CreateButton();
+    [[maybe_unused]] MacOSCheckbox& frameCheckbox = arenaFactory.CreateCheckbox();
+    assert(static_cast<void*>(&frameButton) != static_cast<void*>(&frameCheckbox));
+    assert(arena.GetBlockCount() == 1);
+
+    [[maybe_unused]] const MacOSButton* const firstFrameButton = &frameButton;
+    arena.Reset();
+    assert(&arenaFactory.CreateButton() == firstFrameButton);
+
+    // A frame larger than one block spills into more blocks, which are kept for the next frame
+    for (int i = 0; i < 100; ++i)
+    {
+        arenaFactory.CreateCheckbox();
+    }
+    [[maybe_unused]] const std::size_t blockCount = arena.GetBlockCount();
+    assert(blockCount > 1);
+    arena.Reset();
+    for (int i = 0; i < 100; ++i)
+    {
+        arenaFactory.CreateCheckbox();
+    }
+    assert(arena.GetBlockCount() == blockCount);
+
+    [[maybe_unused]] bool threw = false;
+    try
+    {
+        arena.Allocate(512, 8);
+    }
+    catch (const std::bad_alloc&)
+    {
+        threw = true;
+    }
+    assert(threw);
+
+    std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+void TestDrawList()
+{
+    MacOSFactory macFactory;
+    DrawList list = macFactory.CreateDrawList();
+    for (int i = 0; i < 3; ++i)
+    {
+        RenderUI(list);
+    }
+    assert(list.GetButtonCount() == 3 && list.GetCheckboxCount() == 3);
+
+    std::ostringstream painted;
+    list.Paint(painted);
+    const std::string button(MacOSButton::PaintText);
+    const std::string checkbox(MacOSCheckbox::PaintText);
+    assert(painted.str() == button + button + button + checkbox + checkbox + checkbox);
+
+    // Painting keeps the widgets, Clear drops them
+    std::ostringstream repainted;
+    list.Paint(repainted);
+    assert(repainted.str() == painted.str());
+    list.Clear();
+    std::ostringstream empty;
+    list.Paint(empty);
+    assert(empty.str().empty());
+
+    // Painted in several chunks
+    for (int i = 0; i < 1000; ++i)
+    {
+        list.AddCheckbox();
+    }
+    std::ostringstream chunked;
+    list.Paint(chunked);
+    std::string expected;
+    for (int i = 0; i < 1000; ++i)
+    {
+        expected += checkbox;
+    }
+    assert(chunked.str() == expected);
+
+    // Text longer than a chunk is written as it is
+    const std::string longText(10000, 'x');
+    DrawList longList(longText, checkbox);
+    longList.AddButton();
+    longList.AddButton();
+    std::ostringstream longPainted;
+    longList.Paint(longPainted);
+    assert(longPainted.str() == longText + longText);
+
+    DrawList windowsList = CachedWindowsFactory().CreateDrawList();
+    windowsList.AddCheckbox();
+    std::ostringstream windowsPainted;
+    windowsList.Paint(windowsPainted);
+    assert(windowsPainted.str() == WindowsCheckbox::PaintText);
+
+    // A factory that only implements the widget methods still compiles and renders, but has no draw list
+    class WidgetOnlyFactory : public GUIFactory
+    {
+    public:
+        std::shared_ptr<Button> CreateButton() const override { return std::make_shared<MacOSButton>(); }
+        std::shared_ptr<Checkbox> CreateCheckbox() const override { return std::make_shared<MacOSCheckbox>(); }
+    };
+    const WidgetOnlyFactory widgetOnlyFactory;
+    std::ostringstream widgetOnlyPainted;
+    std::streambuf* const console = std::cout.rdbuf(widgetOnlyPainted.rdbuf());
+    RenderUI(widgetOnlyFactory);
+    std::cout.rdbuf(console);
+    assert(widgetOnlyPainted.str() == button + checkbox);
+
+    [[maybe_unused]] bool refused = false;
+    try
+    {
+        widgetOnlyFactory.CreateDrawList();
+    }
+    catch (const std::logic_error&)
+    {
+        refused = true;
+    }
+    assert(refused);
+
+    std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+void TestStaticGUIFactory()
+{
+    static_assert(std::is_same_v<decltype(StaticGUIFactory<WindowsTraits>().CreateButton()), WindowsButton>, "Concrete products");
+    static_assert(std::is_same_v<decltype(StaticGUIFactory<MacOSTraits>().CreateCheckbox()), MacOSCheckbox>, "Concrete products");
+
+    // Same output as the runtime factories
+    [[maybe_unused]] auto render = [](auto& Factory)
+        {
+            std::ostringstream painted;
+            std::streambuf* const console = std::cout.rdbuf(painted.rdbuf());
+            RenderUI(Factory);
+            std::cout.rdbuf(console);
+            return painted.str();
+        };
+
+    [[maybe_unused]] StaticGUIFactory<WindowsTraits> staticWindowsFactory;
+    WindowsFactory windowsFactory;
+    assert(render(staticWindowsFactory) == render(windowsFactory));
+
+    StaticGUIFactory<MacOSTraits> staticMacFactory;
+    MacOSFactory macFactory;
+    assert(render(staticMacFactory) == render(macFactory));
+
+    DrawList list = staticMacFactory.CreateDrawList();
+    list.AddButton();
+    std::ostringstream painted;
+    list.Paint(painted);
+    assert(painted.str() == MacOSButton::PaintText);
+
+    std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+// Runs RenderFrame Frames times with std::cout in a failed state, so Paint costs next to nothing
+// and the numbers show how widgets are created and called
+template<typename Func>
+void BenchmarkRenderFrames(const std::string& Name, std::size_t Frames, Func&& RenderFrame)
+{
+    Benchmark::Run(Name, Frames, [&RenderFrame](std::size_t Count)
+        {
+            std::cout.setstate(std::ios_base::badbit);
+            for (std::size_t i = 0; i < Count; ++i)
+            {
+                RenderFrame();
+            }
+            std::cout.clear();
+        });
+}
+
+// Frames per second of RenderUI with freshly allocated, cached and arena allocated widgets
+void BenchmarkWidgetFactories()
+{
+    const std::size_t Frames = 2000000;
+
+    WindowsFactory windowsFactory;
+    BenchmarkRenderFrames("RenderUI, std::make_shared widgets", Frames, [&windowsFactory]() { RenderUI(windowsFactory); });
+
+    CachedWindowsFactory cachedFactory;
+    BenchmarkRenderFrames("RenderUI, cached flyweight widgets", Frames, [&cachedFactory]() { RenderUI(cachedFactory); });
+
+    FrameArena arena;
+    ArenaWindowsFactory arenaFactory(arena);
+    BenchmarkRenderFrames("RenderUI, arena widgets reset every frame", Frames, [&arena, &arenaFactory]()
+        {
+            RenderUI(arenaFactory);
+            arena.Reset();
+        });
+}
+
+// RenderUI through the runtime GUIFactory interface versus a family fixed at compile time
+void BenchmarkStaticGUIFactory()
+{
+    const std::size_t Frames = 2000000;
+
+    // Hidden behind DoNotOptimize so the compiler cannot see the dynamic type and devirtualize the calls
+    CachedWindowsFactory cachedFactory;
+    const GUIFactory* runtimeFactory = &cachedFactory;
+    Benchmark::DoNotOptimize(runtimeFactory);
+    BenchmarkRenderFrames("RenderUI, GUIFactory (cached widgets)", Frames, [runtimeFactory]() { RenderUI(*runtimeFactory); });
+
+    StaticGUIFactory<WindowsTraits> staticFactory;
+    BenchmarkRenderFrames("RenderUI, StaticGUIFactory<WindowsTraits>", Frames, [&staticFactory]() { RenderUI(staticFactory); });
+}
+
+// Accepts and discards everything written to it
+class DiscardBuffer : public std::streambuf
+{
+protected:
+    std::streamsize xsputn(const char*, std::streamsize Count) override { return Count; }
+    int_type overflow(int_type Character) override { return traits_type::not_eof(Character); }
+};
+
+// Painting 100k widgets one by one through RenderUI versus queueing them in a DrawList.
+// std::cout writes into a discarding buffer, so the stream calls are measured but not the terminal.
+void BenchmarkDrawList()
+{
+    const std::size_t Widgets = 100000;
+    const std::size_t Repetitions = 20;
+
+    DiscardBuffer discard;
+    WindowsFactory windowsFactory;
+    CachedWindowsFactory cachedFactory;
+    DrawList list = cachedFactory.CreateDrawList();
+
+    auto paintWidgets = [&discard](const char* Name, auto&& PaintAll)
+        {
+            Benchmark::Run(Name, Widgets * Repetitions, [&discard, &PaintAll](std::size_t Count)
+                {
+                    std::streambuf* const console = std::cout.rdbuf(&discard);
+                    for (std::size_t i = 0; i < Count / Widgets; ++i)
+                    {
+                        PaintAll();
+                    }
+                    std::cout.rdbuf(console);
+                });
+        };
+
+    paintWidgets("100k widgets, RenderUI std::make_shared", [&windowsFactory]()
+        {
+            for (std::size_t i = 0; i < Widgets / 2; ++i)
+            {
+                RenderUI(windowsFactory);
+            }
+        });
+    paintWidgets("100k widgets, RenderUI cached flyweights", [&cachedFactory]()
+        {
+            for (std::size_t i = 0; i < Widgets / 2; ++i)
+            {
+                RenderUI(cachedFactory);
+            }
+        });
+    paintWidgets("100k widgets, DrawList batches", [&list]()
+        {
+            for (std::size_t i = 0; i < Widgets / 2; ++i)
+            {
+                RenderUI(list);
+            }
+            list.Paint();
+            list.Clear();
+        });
+}
+
 } // namespace AbstractFactory
\ No newline at end of file
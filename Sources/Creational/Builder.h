@@ -16,37 +16,203 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../Benchmark.h"
 
 namespace Builder
 {
 
+// A component name that lives for the rest of the program, so a PC can keep a view of it instead of a copy.
+// Only InternComponentName and the _component string literal make one, e.g. "Intel Core i9"_component.
+class ComponentName
+{
+public:
+	constexpr ComponentName() = default;
+
+	constexpr std::string_view View() const { return Name; }
+	constexpr operator std::string_view() const { return Name; }
+
+private:
+	constexpr explicit ComponentName(std::string_view InName)
+		: Name(InName)
+	{
+	}
+
+	friend ComponentName InternComponentName(std::string_view Name);
+	friend constexpr ComponentName operator""_component(const char* Literal, std::size_t Length);
+
+	std::string_view Name;
+};
+
+// Stores every distinct component name once for the rest of the program, for names only known at run time
+// that many PCs share. Interning takes a lock and may allocate, and the names are never freed: intern a name
+// once and reuse the result for every PC. PC::SetCPU(const std::string&) does not intern.
+inline ComponentName InternComponentName(std::string_view Name)
+{
+	static std::mutex Mutex;
+	static std::unordered_set<std::string> Names;
+
+	std::lock_guard<std::mutex> lock(Mutex);
+	return ComponentName(*Names.emplace(Name).first);
+}
+
+// String literals live for the whole program
+constexpr ComponentName operator""_component(const char* Literal, std::size_t Length)
+{
+	return ComponentName(std::string_view(Literal, Length));
+}
+
+struct PCParts
+{
+	ComponentName CPU;
+	ComponentName GPU;
+	int RAM = 0;
+	int Storage = 0;
+};
+
 class PC
 {
 public:
-	void SetCPU(const std::string& InCPU) { CPU = InCPU; }
-	void SetGPU(const std::string& InGPU) { GPU = InGPU; }
+	PC() = default;
+
+	explicit PC(const PCParts& Parts)
+		: CPU(Parts.CPU)
+		, GPU(Parts.GPU)
+		, RAM(Parts.RAM)
+		, Storage(Parts.Storage)
+	{
+	}
+
+	// Copies the name into this PC, any string will do
+	void SetCPU(const std::string& InCPU) { OwnedCPU = InCPU; CPU = ComponentName(); }
+	void SetGPU(const std::string& InGPU) { OwnedGPU = InGPU; GPU = ComponentName(); }
+
+	// No copy: the name already lives for the whole program
+	void SetCPU(ComponentName InCPU) { CPU = InCPU; }
+	void SetGPU(ComponentName InGPU) { GPU = InGPU; }
 	void SetRAM(int InRAM) { RAM = InRAM; }
 	void SetStorage(int InStorage) { Storage = InStorage; }
 
-	void ShowSpecifications()
+	std::string_view GetCPU() const { return NameOf(CPU, OwnedCPU); }
+	std::string_view GetGPU() const { return NameOf(GPU, OwnedGPU); }
+	int GetRAM() const { return RAM; }
+	int GetStorage() const { return Storage; }
+
+	void ShowSpecifications() const
 	{
 		std::cout << "PC Specifications:\n";
-		std::cout << "CPU: " << CPU << "\n";
-		std::cout << "GPU: " << GPU << "\n";
+		std::cout << "CPU: " << GetCPU() << "\n";
+		std::cout << "GPU: " << GetGPU() << "\n";
 		std::cout << "RAM: " << RAM << " GB\n";
 		std::cout << "Storage: " << Storage << " GB\n";
 	}
 
 private:
-	std::string CPU;
-	std::string GPU;
-	int RAM;
-	int Storage;
+	// A name set from a std::string is kept in Owned, the ComponentName is left empty then
+	static std::string_view NameOf(ComponentName Name, const std::string& Owned)
+	{
+		return Name.View().data() != nullptr ? Name.View() : std::string_view(Owned);
+	}
+
+	ComponentName CPU;
+	ComponentName GPU;
+	std::string OwnedCPU;
+	std::string OwnedGPU;
+	int RAM = 0;
+	int Storage = 0;
 };
 
+enum PCPart : unsigned
+{
+	CPUPart = 1 << 0,
+	GPUPart = 1 << 1,
+	RAMPart = 1 << 2,
+	StoragePart = 1 << 3,
+	AllPCParts = CPUPart | GPUPart | RAMPart | StoragePart
+};
+
+// Fluent builder for a configuration, also at compile time. Parts records in the type which parts are set,
+// so setting a part twice or building with a part missing does not compile:
+//   constexpr PCParts office = PCSpec{}.CPU("Intel Core i5"_component).GPU("Integrated video card"_component).RAM(16).Storage(1000).Build();
+//   PC officePC(office);
+template<unsigned Parts = 0>
+class PCSpec
+{
+public:
+	constexpr PCSpec() = default;
+
+	constexpr PCSpec<Parts | CPUPart> CPU(ComponentName InCPU) const
+	{
+		static_assert((Parts & CPUPart) == 0, "The CPU is already set");
+		PCSpec<Parts | CPUPart> next(Configuration);
+		next.Configuration.CPU = InCPU;
+		return next;
+	}
+
+	constexpr PCSpec<Parts | GPUPart> GPU(ComponentName InGPU) const
+	{
+		static_assert((Parts & GPUPart) == 0, "The GPU is already set");
+		PCSpec<Parts | GPUPart> next(Configuration);
+		next.Configuration.GPU = InGPU;
+		return next;
+	}
+
+	constexpr PCSpec<Parts | RAMPart> RAM(int InRAM) const
+	{
+		static_assert((Parts & RAMPart) == 0, "The RAM is already set");
+		PCSpec<Parts | RAMPart> next(Configuration);
+		next.Configuration.RAM = InRAM;
+		return next;
+	}
+
+	constexpr PCSpec<Parts | StoragePart> Storage(int InStorage) const
+	{
+		static_assert((Parts & StoragePart) == 0, "The storage is already set");
+		PCSpec<Parts | StoragePart> next(Configuration);
+		next.Configuration.Storage = InStorage;
+		return next;
+	}
+
+	constexpr PCParts Build() const
+	{
+		static_assert(Parts == AllPCParts, "Set the CPU, GPU, RAM and storage before building");
+		return Configuration;
+	}
+
+private:
+	template<unsigned OtherParts>
+	friend class PCSpec;
+
+	constexpr explicit PCSpec(const PCParts& InConfiguration)
+		: Configuration(InConfiguration)
+	{
+	}
+
+	PCParts Configuration;
+};
+
+// The standard profiles, built by the compiler: no initialization and no guard at run time
+inline constexpr PCParts GamingPCParts = PCSpec{}.CPU("Intel Core i9"_component).GPU("NVIDIA GeForce RTX 4090"_component).RAM(128).Storage(5000).Build();
+inline constexpr PCParts OfficePCParts = PCSpec{}.CPU("Intel Core i5"_component).GPU("Integrated video card"_component).RAM(16).Storage(1000).Build();
+
 class PCBuilder
 {
 public:
@@ -63,10 +229,10 @@ class GamingPCBuilder : public PCBuilder
 public:
 	GamingPCBuilder() { Computer = std::make_shared<PC>(); }
 
-	void BuildCPU() override { Computer->SetCPU("Intel Core i9"); }
-	void BuildGPU() override { Computer->SetGPU("NVIDIA GeForce RTX 4090"); }
-	void BuildRAM() override { Computer->SetRAM(128); }
-	void BuildStorage() override { Computer->SetStorage(5000); }
+	void BuildCPU() override { Computer->SetCPU(GamingPCParts.CPU); }
+	void BuildGPU() override { Computer->SetGPU(GamingPCParts.GPU); }
+	void BuildRAM() override { Computer->SetRAM(GamingPCParts.RAM); }
+	void BuildStorage() override { Computer->SetStorage(GamingPCParts.Storage); }
 	std::shared_ptr<PC> GetPC() override { return Computer; }
 
 private:
@@ -78,16 +244,233 @@ class OfficePCBuilder : public PCBuilder
 public:
 	OfficePCBuilder() { Computer = std::make_shared<PC>(); }
 
-	void BuildCPU() override { Computer->SetCPU("Intel Core i5"); }
-	void BuildGPU() override { Computer->SetGPU("Integrated video card"); }
-	void BuildRAM() override { Computer->SetRAM(16); }
-	void BuildStorage() override { Computer->SetStorage(1000); }
+	void BuildCPU() override { Computer->SetCPU(OfficePCParts.CPU); }
+	void BuildGPU() override { Computer->SetGPU(OfficePCParts.GPU); }
+	void BuildRAM() override { Computer->SetRAM(OfficePCParts.RAM); }
+	void BuildStorage() override { Computer->SetStorage(OfficePCParts.Storage); }
 	std::shared_ptr<PC> GetPC() override { return Computer; }
 
 private:
 	std::shared_ptr<PC> Computer;
 };
 
+// Builds a PC by value: the PC is assembled inside the builder and moved out, nothing is allocated.
+//   PC officePC = PCValueBuilder().CPU(parts.CPU).GPU(parts.GPU).RAM(16).Storage(1000).Build();
+// Build() is only available on an rvalue, so a builder cannot be used again after its PC was taken.
+class PCValueBuilder
+{
+public:
+	PCValueBuilder() = default;
+
+	explicit PCValueBuilder(const PCParts& Parts)
+		: Computer(Parts)
+	{
+	}
+
+	PCValueBuilder& CPU(ComponentName InCPU) & { Computer.SetCPU(InCPU); return *this; }
+	PCValueBuilder& GPU(ComponentName InGPU) & { Computer.SetGPU(InGPU); return *this; }
+	PCValueBuilder& RAM(int InRAM) & { Computer.SetRAM(InRAM); return *this; }
+	PCValueBuilder& Storage(int InStorage) & { Computer.SetStorage(InStorage); return *this; }
+
+	PCValueBuilder&& CPU(ComponentName InCPU) && { return std::move(CPU(InCPU)); }
+	PCValueBuilder&& GPU(ComponentName InGPU) && { return std::move(GPU(InGPU)); }
+	PCValueBuilder&& RAM(int InRAM) && { return std::move(RAM(InRAM)); }
+	PCValueBuilder&& Storage(int InStorage) && { return std::move(Storage(InStorage)); }
+
+	PC Build() && { return std::move(Computer); }
+
+private:
+	PC Computer;
+};
+
+// Fixed set of worker threads for splitting one loop over all cores
+class ThreadPool
+{
+public:
+	// ThreadCount counts the calling thread too, which works along in ParallelFor
+	explicit ThreadPool(std::size_t ThreadCount = std::max(1u, std::thread::hardware_concurrency()))
+	{
+		try
+		{
+			for (std::size_t i = 1; i < ThreadCount; ++i)
+			{
+				Workers.emplace_back([this]() { WorkerLoop(); });
+			}
+		}
+		catch (...)
+		{
+			StopWorkers();
+			throw;
+		}
+	}
+
+	ThreadPool(const ThreadPool& other) = delete;
+	ThreadPool& operator=(const ThreadPool& other) = delete;
+
+	~ThreadPool()
+	{
+		StopWorkers();
+	}
+
+	std::size_t GetThreadCount() const { return Workers.size() + 1; }
+
+	// Calls Body(Begin, End) for consecutive chunks of [0, Count) on all threads and returns when every
+	// chunk is done. The first exception thrown by Body is rethrown here once the other chunks finished.
+	// Calls from several threads are run one after another. A call made while this pool's loop is running
+	// further up, directly from Body or through loops on other pools (A's Body runs B.ParallelFor, whose Body
+	// runs A.ParallelFor), would wait for itself: it runs its chunks in order on the calling thread instead.
+	template<typename Func>
+	void ParallelFor(std::size_t Count, std::size_t ChunkSize, Func&& Body)
+	{
+		if (Count == 0)
+		{
+			return;
+		}
+
+		if (IsRunningHere())
+		{
+			const std::size_t chunkSize = std::max<std::size_t>(1, ChunkSize);
+			for (std::size_t begin = 0; begin < Count; begin += chunkSize)
+			{
+				Body(begin, std::min(begin + chunkSize, Count));
+			}
+			return;
+		}
+
+		std::lock_guard<std::mutex> call(CallMutex);
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			Context = &Body;
+			Invoke = [](void* InContext, std::size_t Begin, std::size_t End) { (*static_cast<std::remove_reference_t<Func>*>(InContext))(Begin, End); };
+			JobSize = Count;
+			JobChunkSize = std::max<std::size_t>(1, ChunkSize);
+			JobOuterLoops = RunningLoops;
+			NextIndex.store(0, std::memory_order_relaxed);
+			BusyWorkers = Workers.size();
+			Error = nullptr;
+			++Generation;
+		}
+		WorkAvailable.notify_all();
+
+		RunChunks();
+
+		std::unique_lock<std::mutex> lock(Mutex);
+		WorkDone.wait(lock, [this]() { return BusyWorkers == 0; });
+		if (Error)
+		{
+			std::rethrow_exception(std::exchange(Error, nullptr));
+		}
+	}
+
+private:
+	// One loop being run on the current thread, linked to the loops the caller of its ParallelFor was running
+	struct RunningLoop
+	{
+		const ThreadPool* Pool;
+		const RunningLoop* Outer;
+	};
+
+	bool IsRunningHere() const
+	{
+		for (const RunningLoop* loop = RunningLoops; loop != nullptr; loop = loop->Outer)
+		{
+			if (loop->Pool == this)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void StopWorkers()
+	{
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			Stopping = true;
+		}
+		WorkAvailable.notify_all();
+		for (std::thread& worker : Workers)
+		{
+			worker.join();
+		}
+	}
+
+	void WorkerLoop()
+	{
+		std::uint64_t seenGeneration = 0;
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(Mutex);
+				WorkAvailable.wait(lock, [this, seenGeneration]() { return Stopping || Generation != seenGeneration; });
+				if (Stopping)
+				{
+					return;
+				}
+				seenGeneration = Generation;
+			}
+
+			RunChunks();
+
+			std::lock_guard<std::mutex> lock(Mutex);
+			if (--BusyWorkers == 0)
+			{
+				WorkDone.notify_one();
+			}
+		}
+	}
+
+	void RunChunks()
+	{
+		// Workers inherit the caller's loops, which stay on its stack until the job is done
+		const RunningLoop loop{ this, JobOuterLoops };
+		const RunningLoop* const previousLoops = std::exchange(RunningLoops, &loop);
+		while (true)
+		{
+			const std::size_t begin = NextIndex.fetch_add(JobChunkSize, std::memory_order_relaxed);
+			if (begin >= JobSize)
+			{
+				RunningLoops = previousLoops;
+				return;
+			}
+
+			try
+			{
+				Invoke(Context, begin, std::min(begin + JobChunkSize, JobSize));
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(Mutex);
+				if (!Error)
+				{
+					Error = std::current_exception();
+				}
+			}
+		}
+	}
+
+	// The innermost loop the current thread is running chunks of, to detect nested calls
+	static inline thread_local const RunningLoop* RunningLoops = nullptr;
+
+	std::vector<std::thread> Workers;
+	std::mutex CallMutex;
+	std::mutex Mutex;
+	std::condition_variable WorkAvailable;
+	std::condition_variable WorkDone;
+	bool Stopping = false;
+	std::uint64_t Generation = 0;
+	std::size_t BusyWorkers = 0;
+	std::exception_ptr Error;
+
+	// The current job, written under Mutex before Generation changes
+	void* Context = nullptr;
+	void (*Invoke)(void*, std::size_t, std::size_t) = nullptr;
+	std::size_t JobSize = 0;
+	std::size_t JobChunkSize = 1;
+	const RunningLoop* JobOuterLoops = nullptr;
+	std::atomic<std::size_t> NextIndex{ 0 };
+};
+
 class Director
 {
 public:
@@ -106,6 +489,22 @@ public:
 		return nullptr;
 	}
 
+	// Builds one PC per spec on the pool's threads. Results are written straight into a vector sized up front,
+	// Result[i] is always built from Specs[i] whatever the thread count. Leaves the Builder alone.
+	std::vector<PC> BuildMany(const std::vector<PCParts>& Specs, ThreadPool& Pool) const
+	{
+		std::vector<PC> results(Specs.size());
+		const std::size_t chunkSize = std::max<std::size_t>(256, Specs.size() / (Pool.GetThreadCount() * 8));
+		Pool.ParallelFor(Specs.size(), chunkSize, [&Specs, &results](std::size_t Begin, std::size_t End)
+			{
+				for (std::size_t i = Begin; i < End; ++i)
+				{
+					results[i] = PCValueBuilder(Specs[i]).Build();
+				}
+			});
+		return results;
+	}
+
 private:
 	std::shared_ptr<PCBuilder> Builder;
 };
@@ -126,4 +525,248 @@ void TestBuilderPattern()
 	officePC->ShowSpecifications();
 }
 
+void TestPCValueBuilder()
+{
+	// Equal names share one interned copy
+	const ComponentName cpu = InternComponentName(std::string("AMD Ryzen 9"));
+	assert(cpu.View() == "AMD Ryzen 9");
+	assert(InternComponentName(std::string("AMD Ryzen 9")).View().data() == cpu.View().data());
+
+	// A name from a temporary string is copied into the PC, copies of the PC keep their own
+	PC assembled;
+	assembled.SetCPU(std::string("AMD Ryzen 7") + " 7800X3D");
+	assembled.SetGPU("AMD Radeon RX 7900");
+	assert(assembled.GetCPU() == "AMD Ryzen 7 7800X3D" && assembled.GetGPU() == "AMD Radeon RX 7900");
+	[[maybe_unused]] const PC copied = assembled;
+	assembled.SetCPU(std::string("Intel Core Ultra 9"));
+	assert(copied.GetCPU() == "AMD Ryzen 7 7800X3D" && assembled.GetCPU() == "Intel Core Ultra 9");
+	assembled.SetCPU(cpu);
+	assert(assembled.GetCPU().data() == cpu.View().data());
+
+	[[maybe_unused]] const PC customPC = PCValueBuilder().CPU(cpu).GPU(GamingPCParts.GPU).RAM(64).Storage(2000).Build();
+	assert(customPC.GetCPU().data() == cpu.View().data() && customPC.GetGPU() == "NVIDIA GeForce RTX 4090");
+	assert(customPC.GetRAM() == 64 && customPC.GetStorage() == 2000);
+
+	// Same PC as the Director builds
+	Director director;
+	director.SetBuilder(std::make_shared<OfficePCBuilder>());
+	const std::shared_ptr<PC> directorPC = director.BuildComputer();
+	[[maybe_unused]] const PC officePC = PCValueBuilder(OfficePCParts).Build();
+	assert(officePC.GetCPU() == directorPC->GetCPU() && officePC.GetGPU() == directorPC->GetGPU());
+	assert(officePC.GetRAM() == directorPC->GetRAM() && officePC.GetStorage() == directorPC->GetStorage());
+
+	// A named builder is moved from explicitly to build
+	PCValueBuilder builder;
+	builder.CPU(OfficePCParts.CPU).RAM(8);
+	builder.Storage(256);
+	[[maybe_unused]] const PC smallPC = std::move(builder).Build();
+	assert(smallPC.GetCPU() == "Intel Core i5" && smallPC.GetGPU().empty() && smallPC.GetRAM() == 8 && smallPC.GetStorage() == 256);
+	static_assert(!std::is_invocable_v<decltype(&PCValueBuilder::Build), PCValueBuilder&>, "Build() needs an rvalue builder");
+
+	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+void TestBuildMany()
+{
+	std::vector<PCParts> specs;
+	for (int i = 0; i < 10001; ++i)
+	{
+		PCParts spec = i % 2 == 0 ? GamingPCParts : OfficePCParts;
+		spec.RAM = i;
+		specs.push_back(spec);
+	}
+
+	// More threads than cores, the order of the results must not depend on the scheduling
+	Director director;
+	for (std::size_t threadCount : { 1, 3, 8 })
+	{
+		ThreadPool pool(threadCount);
+		assert(pool.GetThreadCount() == threadCount);
+
+		const std::vector<PC> computers = director.BuildMany(specs, pool);
+		assert(computers.size() == specs.size());
+		for (std::size_t i = 0; i < specs.size(); ++i)
+		{
+			assert(computers[i].GetRAM() == specs[i].RAM && computers[i].GetCPU() == specs[i].CPU);
+			assert(computers[i].GetGPU() == specs[i].GPU && computers[i].GetStorage() == specs[i].Storage);
+		}
+		assert(director.BuildMany({}, pool).empty());
+	}
+
+	// The pool stays usable after a failed loop
+	ThreadPool pool(4);
+	std::atomic<std::size_t> visited(0);
+	[[maybe_unused]] bool threw = false;
+	try
+	{
+		pool.ParallelFor(1000, 10, [&visited](std::size_t Begin, std::size_t End)
+			{
+				visited += End - Begin;
+				if (Begin == 500)
+				{
+					throw std::runtime_error("Broken spec");
+				}
+			});
+	}
+	catch (const std::runtime_error&)
+	{
+		threw = true;
+	}
+	assert(threw && visited == 1000);
+	assert(director.BuildMany(specs, pool).back().GetRAM() == 10000);
+
+	// A loop started from inside another one on the same pool runs inline instead of deadlocking
+	std::vector<int> cells(64 * 64, 0);
+	pool.ParallelFor(64, 4, [&pool, &cells](std::size_t RowBegin, std::size_t RowEnd)
+		{
+			for (std::size_t row = RowBegin; row < RowEnd; ++row)
+			{
+				pool.ParallelFor(64, 8, [&cells, row](std::size_t Begin, std::size_t End)
+					{
+						for (std::size_t column = Begin; column < End; ++column)
+						{
+							++cells[row * 64 + column];
+						}
+					});
+			}
+		});
+	assert(std::all_of(cells.begin(), cells.end(), [](int Cell) { return Cell == 1; }));
+
+	// Also through another pool: the inner loop on the first pool may land on a worker of the second one
+	ThreadPool otherPool(3);
+	std::fill(cells.begin(), cells.end(), 0);
+	pool.ParallelFor(8, 1, [&pool, &otherPool, &cells](std::size_t Block, std::size_t)
+		{
+			otherPool.ParallelFor(8, 1, [&pool, &cells, Block](std::size_t Row, std::size_t)
+				{
+					const std::size_t first = (Block * 8 + Row) * 64;
+					pool.ParallelFor(64, 16, [&cells, first](std::size_t Begin, std::size_t End)
+						{
+							for (std::size_t column = Begin; column < End; ++column)
+							{
+								++cells[first + column];
+							}
+						});
+				});
+		});
+	assert(std::all_of(cells.begin(), cells.end(), [](int Cell) { return Cell == 1; }));
+
+	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+void TestPCSpec()
+{
+	static_assert(GamingPCParts.CPU.View() == "Intel Core i9" && GamingPCParts.GPU.View() == "NVIDIA GeForce RTX 4090", "Built at compile time");
+	static_assert(GamingPCParts.RAM == 128 && GamingPCParts.Storage == 5000, "Built at compile time");
+	static_assert(OfficePCParts.RAM == 16 && OfficePCParts.Storage == 1000, "Built at compile time");
+
+	// Any order of the parts, and at run time too
+	constexpr PCParts workstation = PCSpec{}.Storage(4000).RAM(256).GPU("NVIDIA RTX A6000"_component).CPU("AMD Threadripper"_component).Build();
+	static_assert(workstation.CPU.View() == "AMD Threadripper" && workstation.RAM == 256, "Parts can come in any order");
+	static_assert(std::is_same_v<decltype(PCSpec{}.CPU(""_component).RAM(0)), PCSpec<CPUPart | RAMPart>>, "The type tracks the parts set");
+
+	const int ram = GamingPCParts.RAM * 2;
+	[[maybe_unused]] const PC upgraded(PCSpec{}.CPU(GamingPCParts.CPU).GPU(GamingPCParts.GPU).RAM(ram).Storage(5000).Build());
+	assert(upgraded.GetRAM() == 256 && upgraded.GetCPU() == GamingPCParts.CPU.View());
+
+	// Same PC as the Director builds
+	Director director;
+	director.SetBuilder(std::make_shared<GamingPCBuilder>());
+	const std::shared_ptr<PC> directorPC = director.BuildComputer();
+	assert(directorPC->GetCPU() == GamingPCParts.CPU.View() && directorPC->GetGPU() == GamingPCParts.GPU.View());
+	assert(directorPC->GetRAM() == GamingPCParts.RAM && directorPC->GetStorage() == GamingPCParts.Storage);
+
+	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+// Configurations built per second by the Director with a shared_ptr builder, by PCValueBuilder and
+// by copying a profile the compiler built
+void BenchmarkPCBuilders()
+{
+	const std::size_t Iterations = 2000000;
+
+	Benchmark::Run("Director::BuildComputer (GamingPCBuilder)", Iterations, [](std::size_t Count)
+		{
+			Director director;
+			for (std::size_t i = 0; i < Count; ++i)
+			{
+				director.SetBuilder(std::make_shared<GamingPCBuilder>());
+				std::shared_ptr<PC> computer = director.BuildComputer();
+				Benchmark::DoNotOptimize(computer);
+			}
+		});
+
+	Benchmark::Run("PCValueBuilder(GamingPCParts).Build()", Iterations, [](std::size_t Count)
+		{
+			for (std::size_t i = 0; i < Count; ++i)
+			{
+				PC computer = PCValueBuilder(GamingPCParts).Build();
+				Benchmark::DoNotOptimize(computer);
+			}
+		});
+
+	Benchmark::Run("PCValueBuilder().CPU().GPU().RAM().Storage().Build()", Iterations, [](std::size_t Count)
+		{
+			const PCParts& parts = GamingPCParts;
+			for (std::size_t i = 0; i < Count; ++i)
+			{
+				PC computer = PCValueBuilder().CPU(parts.CPU).GPU(parts.GPU).RAM(parts.RAM).Storage(parts.Storage).Build();
+				Benchmark::DoNotOptimize(computer);
+			}
+		});
+
+	Benchmark::Run("PC(GamingPCParts), constexpr profile", Iterations, [](std::size_t Count)
+		{
+			for (std::size_t i = 0; i < Count; ++i)
+			{
+				PC computer(GamingPCParts);
+				Benchmark::DoNotOptimize(computer);
+			}
+		});
+}
+
+// Director::BuildMany over 50k specs for 1, 2, 4, ... threads, next to building them one at a time
+void BenchmarkBuildMany()
+{
+	const std::size_t Configurations = 50000;
+	const std::size_t Repetitions = 20;
+
+	std::vector<PCParts> specs;
+	for (std::size_t i = 0; i < Configurations; ++i)
+	{
+		specs.push_back(i % 2 == 0 ? GamingPCParts : OfficePCParts);
+	}
+
+	Director director;
+	Benchmark::Run("50k configurations, Director::BuildComputer", Configurations * Repetitions, [&director](std::size_t Count)
+		{
+			for (std::size_t i = 0; i < Count; ++i)
+			{
+				if (i % 2 == 0)
+				{
+					director.SetBuilder(std::make_shared<GamingPCBuilder>());
+				}
+				else
+				{
+					director.SetBuilder(std::make_shared<OfficePCBuilder>());
+				}
+				std::shared_ptr<PC> computer = director.BuildComputer();
+				Benchmark::DoNotOptimize(computer);
+			}
+		});
+
+	for (int threads : Benchmark::ThreadCounts())
+	{
+		ThreadPool pool(threads);
+		Benchmark::Run("50k configurations, Director::BuildMany", threads, Configurations * Repetitions, [&director, &specs, &pool](std::size_t Count)
+			{
+				for (std::size_t i = 0; i < Count / Configurations; ++i)
+				{
+					std::vector<PC> computers = director.BuildMany(specs, pool);
+					Benchmark::DoNotOptimize(computers);
+				}
+			});
+	}
+}
+
 } // namespace Builder
\ No newline at end of file
@@ -12,9 +12,25 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "../Benchmark.h"
 
 namespace FactoryMethod
 {
@@ -30,22 +46,167 @@ public:
 class Car : public Vehicle
 {
 public:
-	std::string GetVehicleType() const override { return "Car"; }
-	float GetRentalCost() const override { return 100; }
+	static constexpr std::string_view TypeName = "Car";
+	static constexpr float RentalCost = 100;
+
+	std::string GetVehicleType() const override { return std::string(TypeName); }
+	float GetRentalCost() const override { return RentalCost; }
 };
 
 class Bike : public Vehicle
 {
 public:
-	std::string GetVehicleType() const override { return "Bike"; }
-	float GetRentalCost() const override { return 50; }
+	static constexpr std::string_view TypeName = "Bike";
+	static constexpr float RentalCost = 50;
+
+	std::string GetVehicleType() const override { return std::string(TypeName); }
+	float GetRentalCost() const override { return RentalCost; }
 };
 
 class Truck : public Vehicle
 {
 public:
-	std::string GetVehicleType() const override { return "Truck"; }
-	float GetRentalCost() const override { return 150; }
+	static constexpr std::string_view TypeName = "Truck";
+	static constexpr float RentalCost = 150;
+
+	std::string GetVehicleType() const override { return std::string(TypeName); }
+	float GetRentalCost() const override { return RentalCost; }
+};
+
+// Vehicles of one type created together in a single allocation: the objects back to back, followed by their
+// rental costs as a plain float array. Indexing works like a span of Vehicle.
+class VehicleBatch
+{
+public:
+	class Iterator
+	{
+	public:
+		Iterator(const VehicleBatch* InBatch, std::size_t InIndex) : Batch(InBatch), Index(InIndex) {}
+
+		Vehicle& operator*() const { return (*Batch)[Index]; }
+		Vehicle* operator->() const { return &(*Batch)[Index]; }
+		Iterator& operator++() { ++Index; return *this; }
+		bool operator==(const Iterator& Other) const { return Index == Other.Index; }
+		bool operator!=(const Iterator& Other) const { return Index != Other.Index; }
+
+	private:
+		const VehicleBatch* Batch;
+		std::size_t Index;
+	};
+
+	VehicleBatch() = default;
+
+	template<typename VehicleType>
+	static VehicleBatch Create(std::size_t Count)
+	{
+		static_assert(std::is_base_of<Vehicle, VehicleType>::value, "Batches hold vehicles");
+		static_assert(std::is_nothrow_default_constructible<VehicleType>::value, "A batch is built without rollback");
+
+		VehicleBatch batch;
+		if (Count == 0)
+		{
+			return batch;
+		}
+
+		// The vehicles, the padding and the costs must fit in one size_t, or the placement news run past the block
+		if (Count > (SIZE_MAX - alignof(float)) / (sizeof(VehicleType) + sizeof(float)))
+		{
+			throw std::bad_array_new_length();
+		}
+
+		batch.CostsOffset = (sizeof(VehicleType) * Count + alignof(float) - 1) / alignof(float) * alignof(float);
+		batch.Alignment = std::max(alignof(VehicleType), alignof(float));
+		batch.Storage = static_cast<unsigned char*>(::operator new(batch.CostsOffset + sizeof(float) * Count, std::align_val_t(batch.Alignment)));
+		batch.Count = Count;
+		batch.ElementAt = [](unsigned char* Storage, std::size_t Index) -> Vehicle*
+			{
+				return std::launder(reinterpret_cast<VehicleType*>(Storage)) + Index;
+			};
+		batch.DestroyAll = [](unsigned char* Storage, std::size_t Count)
+			{
+				VehicleType* vehicles = std::launder(reinterpret_cast<VehicleType*>(Storage));
+				for (std::size_t i = 0; i < Count; ++i)
+				{
+					vehicles[i].~VehicleType();
+				}
+			};
+
+		// One placement new per element: an array placement new may ask for more space than Count objects
+		for (std::size_t i = 0; i < Count; ++i)
+		{
+			VehicleType* vehicle = ::new (static_cast<void*>(batch.Storage + i * sizeof(VehicleType))) VehicleType();
+			// Qualified call, every element is known to be a VehicleType
+			::new (static_cast<void*>(batch.Storage + batch.CostsOffset + i * sizeof(float))) float(vehicle->VehicleType::GetRentalCost());
+		}
+		return batch;
+	}
+
+	VehicleBatch(VehicleBatch&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	VehicleBatch& operator=(VehicleBatch&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Release();
+			Storage = other.Storage;
+			Count = other.Count;
+			CostsOffset = other.CostsOffset;
+			Alignment = other.Alignment;
+			ElementAt = other.ElementAt;
+			DestroyAll = other.DestroyAll;
+
+			other.Storage = nullptr;
+			other.Count = 0;
+		}
+		return *this;
+	}
+
+	VehicleBatch(const VehicleBatch&) = delete;
+	VehicleBatch& operator=(const VehicleBatch&) = delete;
+
+	~VehicleBatch()
+	{
+		Release();
+	}
+
+	std::size_t Size() const { return Count; }
+	bool Empty() const { return Count == 0; }
+
+	Vehicle& operator[](std::size_t Index) const
+	{
+		return *ElementAt(Storage, Index);
+	}
+
+	Iterator begin() const { return Iterator(this, 0); }
+	Iterator end() const { return Iterator(this, Count); }
+
+	// Rental cost of every vehicle, in order
+	const float* GetRentalCosts() const
+	{
+		return Count > 0 ? std::launder(reinterpret_cast<const float*>(Storage + CostsOffset)) : nullptr;
+	}
+
+private:
+	void Release()
+	{
+		if (Storage != nullptr)
+		{
+			DestroyAll(Storage, Count);
+			::operator delete(Storage, std::align_val_t(Alignment));
+			Storage = nullptr;
+			Count = 0;
+		}
+	}
+
+	unsigned char* Storage = nullptr;
+	std::size_t Count = 0;
+	std::size_t CostsOffset = 0;
+	std::size_t Alignment = alignof(float);
+	Vehicle* (*ElementAt)(unsigned char*, std::size_t) = nullptr;
+	void (*DestroyAll)(unsigned char*, std::size_t) = nullptr;
 };
 
 class VehicleFactory
@@ -53,6 +214,16 @@ class VehicleFactory
 public:
 	virtual ~VehicleFactory() = default;
 	virtual std::shared_ptr<Vehicle> CreateVehicle() const = 0;
+	// Count vehicles in one allocation, for renting in bursts. Not pure so that factories written before
+	// batches keep compiling; those only support an empty batch.
+	virtual VehicleBatch CreateVehicles(std::size_t Count) const
+	{
+		if (Count != 0)
+		{
+			throw std::logic_error("This vehicle factory does not create batches");
+		}
+		return VehicleBatch();
+	}
 };
 
 // Concrete Factory classes
@@ -63,6 +234,11 @@ public:
 	{
 		return std::make_shared<Car>();
 	}
+
+	VehicleBatch CreateVehicles(std::size_t Count) const override
+	{
+		return VehicleBatch::Create<Car>(Count);
+	}
 };
 
 class BikeFactory : public VehicleFactory
@@ -72,6 +248,11 @@ public:
 	{
 		return std::make_shared<Bike>();
 	}
+
+	VehicleBatch CreateVehicles(std::size_t Count) const override
+	{
+		return VehicleBatch::Create<Bike>(Count);
+	}
 };
 
 class TruckFactory : public VehicleFactory
@@ -81,8 +262,396 @@ public:
 	{
 		return std::make_shared<Truck>();
 	}
+
+	VehicleBatch CreateVehicles(std::size_t Count) const override
+	{
+		return VehicleBatch::Create<Truck>(Count);
+	}
 };
 
+// Free blocks for objects of type T. Every thread keeps a small cache of them and trades with a shared depot
+// in batches, so a typical allocation or release is a push or pop on a thread-local vector.
+// Memory is never given back to the system, it stays in the pool for the next object.
+template<typename T>
+class RecyclingPool
+{
+public:
+	static void* Allocate()
+	{
+		if (CacheDestroyed)
+		{
+			return GetDepot().Take();
+		}
+
+		Cache& cache = LocalCache();
+		if (cache.Blocks.empty())
+		{
+			GetDepot().Refill(cache.Blocks);
+		}
+
+		void* block = cache.Blocks.back();
+		cache.Blocks.pop_back();
+		return block;
+	}
+
+	// Any thread may release a block, not just the one that allocated it
+	static void Deallocate(void* Block)
+	{
+		if (CacheDestroyed)
+		{
+			GetDepot().Give(Block);
+			return;
+		}
+
+		Cache& cache = LocalCache();
+		cache.Blocks.push_back(Block);
+		if (cache.Blocks.size() >= 2 * BatchSize)
+		{
+			GetDepot().Return(cache.Blocks, BatchSize);
+		}
+	}
+
+private:
+	static constexpr std::size_t BatchSize = 64;
+
+	struct Depot
+	{
+		// Moves a batch of free blocks to Out, carving a new chunk when the depot has too few
+		void Refill(std::vector<void*>& Out)
+		{
+			{
+				std::lock_guard<std::mutex> lock(Mutex);
+				if (FreeBlocks.size() >= BatchSize)
+				{
+					Out.insert(Out.end(), FreeBlocks.end() - BatchSize, FreeBlocks.end());
+					FreeBlocks.resize(FreeBlocks.size() - BatchSize);
+					return;
+				}
+			}
+
+			Carve(Out);
+		}
+
+		// One block, for a thread whose cache is gone
+		void* Take()
+		{
+			{
+				std::lock_guard<std::mutex> lock(Mutex);
+				if (!FreeBlocks.empty())
+				{
+					void* block = FreeBlocks.back();
+					FreeBlocks.pop_back();
+					return block;
+				}
+			}
+
+			std::vector<void*> blocks;
+			Carve(blocks);
+			void* block = blocks.back();
+			blocks.pop_back();
+			Return(blocks, blocks.size());
+			return block;
+		}
+
+		void Give(void* Block)
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			FreeBlocks.push_back(Block);
+		}
+
+		// Moves the last Count blocks of From to the depot
+		void Return(std::vector<void*>& From, std::size_t Count)
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			FreeBlocks.insert(FreeBlocks.end(), From.end() - Count, From.end());
+			From.resize(From.size() - Count);
+		}
+
+		std::mutex Mutex;
+		std::vector<void*> FreeBlocks;
+
+	private:
+		static void Carve(std::vector<void*>& Out)
+		{
+			unsigned char* chunk = static_cast<unsigned char*>(::operator new(sizeof(T) * BatchSize, std::align_val_t(alignof(T))));
+			for (std::size_t i = 0; i < BatchSize; ++i)
+			{
+				Out.push_back(chunk + i * sizeof(T));
+			}
+		}
+	};
+
+	struct Cache
+	{
+		// An exiting thread hands its blocks to the other threads. Thread-local objects destroyed after this
+		// one may still allocate or release blocks, they go straight to the depot.
+		~Cache()
+		{
+			if (!Blocks.empty())
+			{
+				GetDepot().Return(Blocks, Blocks.size());
+			}
+			CacheDestroyed = true;
+		}
+
+		std::vector<void*> Blocks;
+	};
+
+	// Trivially destructible, so it can still be read after the cache is gone
+	static inline thread_local bool CacheDestroyed = false;
+
+	static Cache& LocalCache()
+	{
+		thread_local Cache LocalBlocks;
+		return LocalBlocks;
+	}
+
+	// Never destroyed: objects and thread caches may still release blocks while the program exits
+	static Depot& GetDepot()
+	{
+		static Depot* SharedDepot = new Depot();
+		return *SharedDepot;
+	}
+};
+
+// Allocator over RecyclingPool, for std::allocate_shared. It is rebound to the shared_ptr control block type,
+// so object and control block come from the pool together.
+template<typename T>
+class RecyclingAllocator
+{
+public:
+	using value_type = T;
+
+	RecyclingAllocator() = default;
+
+	template<typename U>
+	RecyclingAllocator(const RecyclingAllocator<U>&) noexcept {}
+
+	T* allocate(std::size_t Count)
+	{
+		if (Count != 1)
+		{
+			return static_cast<T*>(::operator new(sizeof(T) * Count, std::align_val_t(alignof(T))));
+		}
+		return static_cast<T*>(RecyclingPool<T>::Allocate());
+	}
+
+	void deallocate(T* Pointer, std::size_t Count) noexcept
+	{
+		if (Count != 1)
+		{
+			::operator delete(Pointer, std::align_val_t(alignof(T)));
+			return;
+		}
+		RecyclingPool<T>::Deallocate(Pointer);
+	}
+
+	template<typename U>
+	bool operator==(const RecyclingAllocator<U>&) const noexcept { return true; }
+
+	template<typename U>
+	bool operator!=(const RecyclingAllocator<U>&) const noexcept { return false; }
+};
+
+// Rents out vehicles from per-type pools; a returned vehicle's memory goes straight to the next rental
+template<typename VehicleType>
+class PooledVehicleFactory : public VehicleFactory
+{
+public:
+	std::shared_ptr<Vehicle> CreateVehicle() const override
+	{
+		return std::allocate_shared<VehicleType>(RecyclingAllocator<VehicleType>());
+	}
+
+	VehicleBatch CreateVehicles(std::size_t Count) const override
+	{
+		return VehicleBatch::Create<VehicleType>(Count);
+	}
+};
+
+using PooledCarFactory = PooledVehicleFactory<Car>;
+using PooledBikeFactory = PooledVehicleFactory<Bike>;
+using PooledTruckFactory = PooledVehicleFactory<Truck>;
+
+// Factory over a fixed list of vehicle types known at compile time. A vehicle is a std::variant held by value,
+// names and costs come from the types' constexpr TypeName and RentalCost, and nothing goes through a vtable.
+template<typename... VehicleTypes>
+class StaticVehicleFactory
+{
+public:
+	using VehicleVariant = std::variant<VehicleTypes...>;
+
+	static constexpr std::size_t VehicleTypeCount = sizeof...(VehicleTypes);
+
+	template<typename VehicleType>
+	static VehicleVariant Create()
+	{
+		static_assert((std::is_same<VehicleType, VehicleTypes>::value || ...), "Vehicle type is not registered");
+		return VehicleVariant(std::in_place_type<VehicleType>);
+	}
+
+	// Creates the Index-th registered type, e.g. from IndexOf; std::nullopt for an index out of range
+	static std::optional<VehicleVariant> Create(std::size_t Index)
+	{
+		using CreateFunc = VehicleVariant (*)();
+		static constexpr CreateFunc Creators[] = { &Create<VehicleTypes>... };
+		if (Index >= VehicleTypeCount)
+		{
+			return std::nullopt;
+		}
+		return Creators[Index]();
+	}
+
+	static constexpr std::optional<std::size_t> IndexOf(std::string_view TypeName)
+	{
+		constexpr std::string_view names[] = { VehicleTypes::TypeName... };
+		for (std::size_t i = 0; i < VehicleTypeCount; ++i)
+		{
+			if (names[i] == TypeName)
+			{
+				return i;
+			}
+		}
+		return std::nullopt;
+	}
+
+	static std::string_view GetVehicleType(const VehicleVariant& Vehicle)
+	{
+		return std::visit([](const auto& Concrete) { return std::decay_t<decltype(Concrete)>::TypeName; }, Vehicle);
+	}
+
+	static float GetRentalCost(const VehicleVariant& Vehicle)
+	{
+		return std::visit([](const auto& Concrete) { return std::decay_t<decltype(Concrete)>::RentalCost; }, Vehicle);
+	}
+};
+
+using StaticVehicleRegistry = StaticVehicleFactory<Car, Bike, Truck>;
+
+static_assert(StaticVehicleRegistry::IndexOf("Bike") == 1, "Vehicle lookup by name happens at compile time");
+static_assert(Truck::RentalCost == 150, "Vehicle costs are compile-time constants");
+
+// Creates vehicles from a type name, e.g. one read off the wire. Vehicle types add themselves through a
+// VehicleRegistration; the entries are kept sorted by name in one flat array, so a lookup is a binary search
+// over contiguous memory and allocates nothing. Each entry also carries the first eight characters of its
+// name packed into an integer, so the search steps compare integers and only equal prefixes fall back to a
+// string comparison.
+class VehicleNameRegistry
+{
+public:
+	using CreateFunc = std::shared_ptr<Vehicle> (*)();
+
+	// A function-local static, so registrations made while other globals are initialized always find it
+	static VehicleNameRegistry& Get()
+	{
+		static VehicleNameRegistry Instance;
+		return Instance;
+	}
+
+	// Name must outlive the registry, a string literal or a constexpr TypeName.
+	// Registering happens during static initialization or before any lookup: the registry is not locked.
+	// Returns false if the name is taken.
+	bool Register(std::string_view Name, CreateFunc Create)
+	{
+		const Entry* position = LowerBound(Name, PrefixOf(Name));
+		if (position != Entries.data() + Entries.size() && position->Name == Name)
+		{
+			return false;
+		}
+		Entries.insert(Entries.begin() + (position - Entries.data()), Entry{ PrefixOf(Name), Name, Create });
+		return true;
+	}
+
+	// nullptr for an unknown name
+	CreateFunc Find(std::string_view Name) const
+	{
+		const std::uint64_t prefix = PrefixOf(Name);
+		const Entry* found = LowerBound(Name, prefix);
+		return found != Entries.data() + Entries.size() && found->Matches(Name, prefix) ? found->Create : nullptr;
+	}
+
+	std::shared_ptr<Vehicle> Create(std::string_view Name) const
+	{
+		const CreateFunc create = Find(Name);
+		return create != nullptr ? create() : nullptr;
+	}
+
+	std::size_t Size() const { return Entries.size(); }
+
+private:
+	VehicleNameRegistry() = default;
+
+	struct Entry
+	{
+		std::uint64_t Prefix;
+		std::string_view Name;
+		CreateFunc Create;
+
+		// Names of up to eight characters are told apart by prefix and length alone
+		bool Before(std::string_view OtherName, std::uint64_t OtherPrefix) const
+		{
+			if (Prefix != OtherPrefix)
+			{
+				return Prefix < OtherPrefix;
+			}
+			return Name.size() <= 8 && OtherName.size() <= 8 ? Name.size() < OtherName.size() : Name < OtherName;
+		}
+
+		bool Matches(std::string_view OtherName, std::uint64_t OtherPrefix) const
+		{
+			return Prefix == OtherPrefix && Name.size() == OtherName.size() && (Name.size() <= 8 || Name == OtherName);
+		}
+	};
+
+	// Big-endian, zero padded: integer order of the prefixes matches the string order of the names
+	static std::uint64_t PrefixOf(std::string_view Name)
+	{
+		std::uint64_t prefix = 0;
+		const std::size_t length = std::min<std::size_t>(Name.size(), 8);
+		for (std::size_t i = 0; i < length; ++i)
+		{
+			prefix |= static_cast<std::uint64_t>(static_cast<unsigned char>(Name[i])) << (56 - 8 * i);
+		}
+		return prefix;
+	}
+
+	// First entry not ordered before Name. Halves the range with a conditional move instead of a branch per step.
+	const Entry* LowerBound(std::string_view Name, std::uint64_t Prefix) const
+	{
+		if (Entries.empty())
+		{
+			return Entries.data();
+		}
+
+		const Entry* base = Entries.data();
+		std::size_t length = Entries.size();
+		while (length > 1)
+		{
+			const std::size_t half = length / 2;
+			base = base[half - 1].Before(Name, Prefix) ? base + half : base;
+			length -= half;
+		}
+		return base + base->Before(Name, Prefix);
+	}
+
+	std::vector<Entry> Entries;
+};
+
+// Registers VehicleType under its TypeName when constructed. Declare it as an inline variable next to the
+// type so there is exactly one per program, however many files include the header.
+template<typename VehicleType>
+struct VehicleRegistration
+{
+	VehicleRegistration()
+	{
+		VehicleNameRegistry::Get().Register(VehicleType::TypeName, []() -> std::shared_ptr<Vehicle> { return std::make_shared<VehicleType>(); });
+	}
+};
+
+inline const VehicleRegistration<Car> CarRegistration;
+inline const VehicleRegistration<Bike> BikeRegistration;
+inline const VehicleRegistration<Truck> TruckRegistration;
+
 
 void RentVehicle(const VehicleFactory& factory)
 {
@@ -90,6 +659,48 @@ void RentVehicle(const VehicleFactory& factory)
 	std::cout << "Rented a " << vehicle->GetVehicleType() << " with a rental cost of $" << vehicle->GetRentalCost() << " per day.\n";
 }
 
+// Sum of the batch's rental costs. Eight independent partial sums keep the additions free of a serial
+// dependency, so the compiler can put them in vector registers without reordering a single float sum.
+float TotalRentalCost(const VehicleBatch& Batch)
+{
+	constexpr std::size_t Lanes = 8;
+
+	const float* costs = Batch.GetRentalCosts();
+	const std::size_t count = Batch.Size();
+
+	float partial[Lanes] = {};
+	std::size_t i = 0;
+	for (; i + Lanes <= count; i += Lanes)
+	{
+		for (std::size_t lane = 0; lane < Lanes; ++lane)
+		{
+			partial[lane] += costs[i + lane];
+		}
+	}
+	for (; i < count; ++i)
+	{
+		partial[0] += costs[i];
+	}
+
+	float total = 0;
+	for (float sum : partial)
+	{
+		total += sum;
+	}
+	return total;
+}
+
+void RentVehicles(const VehicleFactory& factory, std::size_t Count)
+{
+	const VehicleBatch vehicles = factory.CreateVehicles(Count);
+	if (vehicles.Empty())
+	{
+		return;
+	}
+	std::cout << "Rented " << vehicles.Size() << " x " << vehicles[0].GetVehicleType() << " with a total rental cost of $"
+		<< TotalRentalCost(vehicles) << " per day.\n";
+}
+
 void TestFactoryMethod()
 {
 	CarFactory carFactory;
@@ -101,4 +712,367 @@ void TestFactoryMethod()
 	RentVehicle(truckFactory);
 }
 
+template<typename VehicleType>
+void RentStaticVehicle()
+{
+	const StaticVehicleRegistry::VehicleVariant vehicle = StaticVehicleRegistry::Create<VehicleType>();
+	std::cout << "Rented a " << StaticVehicleRegistry::GetVehicleType(vehicle) << " with a rental cost of $"
+		<< StaticVehicleRegistry::GetRentalCost(vehicle) << " per day.\n";
+}
+
+void TestStaticVehicleFactory()
+{
+	RentStaticVehicle<Car>();
+	RentStaticVehicle<Bike>();
+	RentStaticVehicle<Truck>();
+
+	const StaticVehicleRegistry::VehicleVariant bike = *StaticVehicleRegistry::Create(*StaticVehicleRegistry::IndexOf("Bike"));
+	assert(std::holds_alternative<Bike>(bike));
+	assert(StaticVehicleRegistry::GetVehicleType(bike) == "Bike");
+	assert(StaticVehicleRegistry::GetRentalCost(bike) == 50);
+	assert(!StaticVehicleRegistry::IndexOf("Boat").has_value());
+	assert(!StaticVehicleRegistry::Create(StaticVehicleRegistry::VehicleTypeCount).has_value());
+
+	// Same answers as the virtual hierarchy
+	assert(StaticVehicleRegistry::GetVehicleType(StaticVehicleRegistry::Create<Truck>()) == TruckFactory().CreateVehicle()->GetVehicleType());
+
+	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+void TestVehicleBatches()
+{
+	CarFactory carFactory;
+	PooledTruckFactory truckFactory;
+
+	RentVehicles(carFactory, 3);
+	RentVehicles(truckFactory, 1000);
+
+	VehicleBatch bikes = BikeFactory().CreateVehicles(37);
+	assert(bikes.Size() == 37);
+	assert(TotalRentalCost(bikes) == 37 * 50);
+	for ([[maybe_unused]] const Vehicle& bike : bikes)
+	{
+		assert(bike.GetVehicleType() == "Bike");
+	}
+
+	// One block: the vehicles sit one stride apart
+	assert(reinterpret_cast<const unsigned char*>(&bikes[1]) - reinterpret_cast<const unsigned char*>(&bikes[0]) == sizeof(Bike));
+
+	VehicleBatch moved = std::move(bikes);
+	assert(moved.Size() == 37 && bikes.Empty());
+	assert(carFactory.CreateVehicles(0).Empty());
+
+	// A count whose byte size does not fit in a size_t is refused before anything is allocated
+	[[maybe_unused]] bool refused = false;
+	try
+	{
+		carFactory.CreateVehicles(SIZE_MAX / sizeof(Car) + 1);
+	}
+	catch (const std::bad_array_new_length&)
+	{
+		refused = true;
+	}
+	assert(refused);
+
+	// A factory that only implements CreateVehicle still compiles and refuses batches
+	class SingleVehicleFactory : public VehicleFactory
+	{
+	public:
+		std::shared_ptr<Vehicle> CreateVehicle() const override { return std::make_shared<Car>(); }
+	};
+	const SingleVehicleFactory singleFactory;
+	assert(singleFactory.CreateVehicles(0).Empty());
+	refused = false;
+	try
+	{
+		RentVehicles(singleFactory, 3);
+	}
+	catch (const std::logic_error&)
+	{
+		refused = true;
+	}
+	assert(refused);
+
+	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+void TestVehicleNameRegistry()
+{
+	const VehicleNameRegistry& registry = VehicleNameRegistry::Get();
+
+	for (std::string_view name : { "Car", "Bike", "Truck" })
+	{
+		const std::shared_ptr<Vehicle> vehicle = registry.Create(name);
+		assert(vehicle != nullptr && vehicle->GetVehicleType() == name);
+	}
+	assert(registry.Create("Boat") == nullptr);
+	assert(registry.Find("") == nullptr);
+	assert(registry.Find("Zeppelin") == nullptr);
+
+	// Names may be added in any order and only once
+	VehicleNameRegistry& writableRegistry = VehicleNameRegistry::Get();
+	[[maybe_unused]] const std::size_t size = writableRegistry.Size();
+	assert(writableRegistry.Register("Automobile", []() -> std::shared_ptr<Vehicle> { return std::make_shared<Car>(); }));
+	assert(!writableRegistry.Register("Car", []() -> std::shared_ptr<Vehicle> { return std::make_shared<Bike>(); }));
+	assert(writableRegistry.Size() == size + 1);
+	assert(registry.Create("Automobile")->GetVehicleType() == "Car");
+	assert(registry.Find("Automobiles") == nullptr && registry.Find("Automobil") == nullptr && registry.Find("Ca") == nullptr);
+	assert(registry.Create("Car")->GetVehicleType() == "Car");
+
+	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+void TestPooledVehicleFactory()
+{
+	PooledCarFactory carFactory;
+	PooledBikeFactory bikeFactory;
+	PooledTruckFactory truckFactory;
+
+	assert(carFactory.CreateVehicle()->GetVehicleType() == "Car");
+	assert(bikeFactory.CreateVehicle()->GetRentalCost() == 50);
+	assert(truckFactory.CreateVehicle()->GetVehicleType() == "Truck");
+
+	// A returned vehicle's memory is reused by the next rental on the same thread
+	[[maybe_unused]] const Vehicle* returned = carFactory.CreateVehicle().get();
+	assert(carFactory.CreateVehicle().get() == returned);
+
+	// Vehicles may be returned on another thread than the one that rented them
+	std::vector<std::shared_ptr<Vehicle>> rented;
+	for (int i = 0; i < 1000; ++i)
+	{
+		rented.push_back(carFactory.CreateVehicle());
+	}
+	std::thread returning([&rented]() { rented.clear(); });
+	returning.join();
+
+	// Thread-local objects destroyed after the thread's cache still rent and return vehicles
+	struct RentedUntilExit
+	{
+		~RentedUntilExit()
+		{
+			Rented = nullptr;
+			assert(PooledCarFactory().CreateVehicle()->GetRentalCost() == 100);
+		}
+
+		std::shared_ptr<Vehicle> Rented;
+	};
+	std::thread exiting([&carFactory]()
+		{
+			// Constructed before the cache, so destroyed after it
+			thread_local RentedUntilExit rentedUntilExit;
+			rentedUntilExit.Rented = carFactory.CreateVehicle();
+		});
+	exiting.join();
+
+	for (int i = 0; i < 1000; ++i)
+	{
+		rented.push_back(carFactory.CreateVehicle());
+		assert(rented.back()->GetRentalCost() == 100);
+	}
+
+	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+// Rentals per second: rent one vehicle, read its cost, return it; then with 64 vehicles out at a time
+void BenchmarkVehicleFactories()
+{
+	const std::size_t Iterations = 1000000;
+	const std::size_t Outstanding = 64;
+
+	CarFactory carFactory;
+	PooledCarFactory pooledCarFactory;
+
+	auto measure = [Iterations, Outstanding](const std::string& Name, const VehicleFactory& Factory)
+		{
+			for (int threads : Benchmark::ThreadCounts())
+			{
+				Benchmark::RunParallel(Name + " rent/return", threads, Iterations, [&Factory](int, std::size_t Count)
+					{
+						float total = 0;
+						for (std::size_t i = 0; i < Count; ++i)
+						{
+							total += Factory.CreateVehicle()->GetRentalCost();
+						}
+						Benchmark::DoNotOptimize(total);
+					});
+
+				Benchmark::RunParallel(Name + " rent/return in groups", threads, Iterations, [&Factory, Outstanding](int, std::size_t Count)
+					{
+						std::vector<std::shared_ptr<Vehicle>> rented;
+						rented.reserve(Outstanding);
+						for (std::size_t i = 0; i < Count; ++i)
+						{
+							rented.push_back(Factory.CreateVehicle());
+							if (rented.size() == Outstanding)
+							{
+								rented.clear();
+							}
+						}
+						Benchmark::DoNotOptimize(rented);
+					});
+			}
+		};
+
+	measure("CarFactory (std::make_shared)", carFactory);
+	measure("PooledCarFactory", pooledCarFactory);
+}
+
+// Rent a vehicle of a type picked at run time and read its name and cost: through VehicleFactory's virtual
+// functions, and through StaticVehicleRegistry
+void BenchmarkStaticVehicleFactory()
+{
+	const std::size_t Iterations = 10000000;
+
+	const CarFactory carFactory;
+	const BikeFactory bikeFactory;
+	const TruckFactory truckFactory;
+	const VehicleFactory* factories[] = { &carFactory, &bikeFactory, &truckFactory };
+
+	Benchmark::Run("VehicleFactory virtual create/type/cost", Iterations, [&factories](std::size_t Count)
+		{
+			float total = 0;
+			std::size_t nameLengths = 0;
+			for (std::size_t i = 0; i < Count; ++i)
+			{
+				const std::shared_ptr<Vehicle> vehicle = factories[i % 3]->CreateVehicle();
+				total += vehicle->GetRentalCost();
+				nameLengths += vehicle->GetVehicleType().size();
+			}
+			Benchmark::DoNotOptimize(total);
+			Benchmark::DoNotOptimize(nameLengths);
+		});
+
+	Benchmark::Run("StaticVehicleRegistry create/type/cost", Iterations, [](std::size_t Count)
+		{
+			float total = 0;
+			std::size_t nameLengths = 0;
+			for (std::size_t i = 0; i < Count; ++i)
+			{
+				const StaticVehicleRegistry::VehicleVariant vehicle = *StaticVehicleRegistry::Create(i % 3);
+				total += StaticVehicleRegistry::GetRentalCost(vehicle);
+				nameLengths += StaticVehicleRegistry::GetVehicleType(vehicle).size();
+			}
+			Benchmark::DoNotOptimize(total);
+			Benchmark::DoNotOptimize(nameLengths);
+		});
+}
+
+// Bursts of 1000 rentals summing the cost: CreateVehicle in a loop against one CreateVehicles batch
+void BenchmarkVehicleBatches()
+{
+	const std::size_t Burst = 1000;
+	const std::size_t Iterations = 2000 * Burst;
+
+	CarFactory carFactory;
+	PooledCarFactory pooledCarFactory;
+
+	auto measureLoop = [Burst, Iterations](const std::string& Name, const VehicleFactory& Factory)
+		{
+			Benchmark::Run(Name, Iterations, [&Factory, Burst](std::size_t Count)
+				{
+					std::vector<std::shared_ptr<Vehicle>> rented;
+					rented.reserve(Burst);
+					float total = 0;
+					for (std::size_t i = 0; i < Count / Burst; ++i)
+					{
+						for (std::size_t j = 0; j < Burst; ++j)
+						{
+							rented.push_back(Factory.CreateVehicle());
+							total += rented.back()->GetRentalCost();
+						}
+						rented.clear();
+					}
+					Benchmark::DoNotOptimize(total);
+				});
+		};
+
+	measureLoop("CarFactory CreateVehicle x1000", carFactory);
+	measureLoop("PooledCarFactory CreateVehicle x1000", pooledCarFactory);
+
+	Benchmark::Run("CarFactory CreateVehicles(1000)", Iterations, [&carFactory, Burst](std::size_t Count)
+		{
+			float total = 0;
+			for (std::size_t i = 0; i < Count / Burst; ++i)
+			{
+				const VehicleBatch batch = carFactory.CreateVehicles(Burst);
+				total += TotalRentalCost(batch);
+			}
+			Benchmark::DoNotOptimize(total);
+		});
+}
+
+// Resolving a type name to a creation function: an if/else chain, VehicleNameRegistry and a
+// std::unordered_map keyed by std::string
+void BenchmarkVehicleNameLookup()
+{
+	using CreateFunc = VehicleNameRegistry::CreateFunc;
+
+	const std::size_t Iterations = 10000000;
+	const std::string_view names[] = { "Truck", "Car", "Boat", "Bike" };
+
+	auto chain = [](std::string_view Name) -> CreateFunc
+		{
+			if (Name == "Car")
+			{
+				return VehicleNameRegistry::Get().Find("Car");
+			}
+			else if (Name == "Bike")
+			{
+				return VehicleNameRegistry::Get().Find("Bike");
+			}
+			else if (Name == "Truck")
+			{
+				return VehicleNameRegistry::Get().Find("Truck");
+			}
+			return nullptr;
+		};
+
+	// The chain is resolved once up front, the loop only measures the comparisons
+	const CreateFunc car = chain("Car");
+	const CreateFunc bike = chain("Bike");
+	const CreateFunc truck = chain("Truck");
+	Benchmark::Run("if/else chain lookup", Iterations, [&names, car, bike, truck](std::size_t Count)
+		{
+			for (std::size_t i = 0; i < Count; ++i)
+			{
+				const std::string_view name = names[i % 4];
+				CreateFunc found = nullptr;
+				if (name == "Car")
+				{
+					found = car;
+				}
+				else if (name == "Bike")
+				{
+					found = bike;
+				}
+				else if (name == "Truck")
+				{
+					found = truck;
+				}
+				Benchmark::DoNotOptimize(found);
+			}
+		});
+
+	const VehicleNameRegistry& registry = VehicleNameRegistry::Get();
+	Benchmark::Run("VehicleNameRegistry lookup", Iterations, [&names, &registry](std::size_t Count)
+		{
+			for (std::size_t i = 0; i < Count; ++i)
+			{
+				CreateFunc found = registry.Find(names[i % 4]);
+				Benchmark::DoNotOptimize(found);
+			}
+		});
+
+	const std::unordered_map<std::string, CreateFunc> map = { { "Car", car }, { "Bike", bike }, { "Truck", truck } };
+	Benchmark::Run("std::unordered_map<std::string> lookup", Iterations, [&names, &map](std::size_t Count)
+		{
+			for (std::size_t i = 0; i < Count; ++i)
+			{
+				auto found = map.find(std::string(names[i % 4]));
+				CreateFunc create = found != map.end() ? found->second : nullptr;
+				Benchmark::DoNotOptimize(create);
+			}
+		});
+}
+
 } // namespace FactoryMethod
\ No newline at end of file
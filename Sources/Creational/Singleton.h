@@ -5,48 +5,1549 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <memory>
 #include <mutex>
+#include <new>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "../Benchmark.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace Singleton
 {
 
-class Logger
+// Where the Logger's lines end up. Write receives whole lines, possibly many at once.
+class LogSink
+{
+public:
+	virtual ~LogSink() = default;
+
+	virtual void Write(const std::string& Lines) = 0;
+	virtual void Flush() {}
+
+	// A binary sink receives encoded records instead of text lines, see BinaryStreamSink
+	virtual bool IsBinary() const { return false; }
+};
+
+class StreamSink : public LogSink
+{
+public:
+	explicit StreamSink(std::ostream& InStream) : Stream(InStream) {}
+
+	void Write(const std::string& Lines) override { Stream << Lines; }
+	void Flush() override { Stream.flush(); }
+
+private:
+	std::ostream& Stream;
+};
+
+class ConsoleSink : public StreamSink
+{
+public:
+	ConsoleSink() : StreamSink(std::cout) {}
+};
+
+// Stores records undecoded: a frame per record of format site id, payload size and the encoded arguments
+// (native byte order). DecodeBinaryLog turns them into text later, given the run's WriteFormatDictionary output.
+// Open the stream in binary mode.
+class BinaryStreamSink : public StreamSink
+{
+public:
+	explicit BinaryStreamSink(std::ostream& InStream) : StreamSink(InStream) {}
+
+	bool IsBinary() const override { return true; }
+};
+
+// Discards everything, for measuring the logger itself
+class NullSink : public LogSink
+{
+public:
+	void Write(const std::string& Lines) override { Benchmark::DoNotOptimize(Lines); }
+};
+
+struct FileSinkOptions
+{
+	// Segments are named <BasePath>.<index>.log; numbering continues after the highest segment already on disk,
+	// and an existing file is never overwritten
+	std::string BasePath = "Patterns";
+	// Every segment is allocated at this size up front and trimmed to what was written when it is closed
+	std::size_t SegmentBytes = 16 * 1024 * 1024;
+	// A segment older than this is closed on the next write, even if it is not full
+	std::chrono::milliseconds MaxSegmentAge = std::chrono::hours(1);
+	bool Binary = false;
+};
+
+// Writes into a memory-mapped segment file: a record costs a memcpy, the kernel writes the pages back
+// on its own schedule, and the only system calls happen when a segment is opened, rotated or flushed.
+class MappedFileSink : public LogSink
+{
+public:
+	explicit MappedFileSink(const FileSinkOptions& InOptions)
+		: Options(InOptions)
+		, NextIndex(FindNextIndex())
+	{
+		OpenSegment();
+	}
+
+	~MappedFileSink() override
+	{
+		CloseSegment();
+	}
+
+	MappedFileSink(const MappedFileSink&) = delete;
+	MappedFileSink& operator=(const MappedFileSink&) = delete;
+
+	void Write(const std::string& Lines) override
+	{
+		const bool tooOld = std::chrono::steady_clock::now() - SegmentStart >= Options.MaxSegmentAge;
+		if (Used > 0 && (tooOld || Used + Lines.size() > Options.SegmentBytes))
+		{
+			Rotate();
+		}
+
+		// Only a write larger than a whole segment is split
+		const char* data = Lines.data();
+		std::size_t remaining = Lines.size();
+		while (remaining > 0)
+		{
+			if (Used == Options.SegmentBytes)
+			{
+				Rotate();
+			}
+
+			const std::size_t chunk = std::min(remaining, Options.SegmentBytes - Used);
+			std::memcpy(Mapping + Used, data, chunk);
+			Used += chunk;
+			data += chunk;
+			remaining -= chunk;
+		}
+	}
+
+	// Nothing to do: written records are already visible to readers of the file, and the kernel writes the pages
+	// back by itself. The synchronous Logger flushes after every record, a system call here would defeat the point.
+	void Flush() override {}
+
+	// Blocks until everything written so far is on disk
+	void Sync()
+	{
+#ifdef _WIN32
+		FlushViewOfFile(Mapping, Used);
+		FlushFileBuffers(File);
+#else
+		msync(Mapping, Used, MS_SYNC);
+#endif
+	}
+
+	bool IsBinary() const override { return Options.Binary; }
+
+	void Rotate()
+	{
+		CloseSegment();
+		OpenSegment();
+	}
+
+	const std::string& GetSegmentPath() const { return CurrentPath; }
+
+private:
+	// One past the highest segment index on disk: older segments may have been deleted by retention cleanup
+	std::size_t FindNextIndex() const
+	{
+		const std::filesystem::path basePath(Options.BasePath);
+		const std::string prefix = basePath.filename().string() + ".";
+		const std::string_view extension = ".log";
+		const std::filesystem::path directory = basePath.has_parent_path() ? basePath.parent_path() : std::filesystem::path(".");
+
+		std::size_t nextIndex = 0;
+		std::error_code error;
+		for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error))
+		{
+			const std::string name = it->path().filename().string();
+			if (name.size() <= prefix.size() + extension.size() || name.compare(0, prefix.size(), prefix) != 0
+				|| name.compare(name.size() - extension.size(), extension.size(), extension) != 0)
+			{
+				continue;
+			}
+
+			const char* first = name.data() + prefix.size();
+			const char* last = name.data() + name.size() - extension.size();
+			std::size_t index = 0;
+			const std::from_chars_result parsed = std::from_chars(first, last, index);
+			if (parsed.ec == std::errc() && parsed.ptr == last && index >= nextIndex)
+			{
+				nextIndex = index + 1;
+			}
+		}
+		return nextIndex;
+	}
+
+	std::string SegmentPath(std::size_t Index) const
+	{
+		char suffix[32];
+		std::snprintf(suffix, sizeof(suffix), ".%06zu.log", Index);
+		return Options.BasePath + suffix;
+	}
+
+	void OpenSegment()
+	{
+		Used = 0;
+		SegmentStart = std::chrono::steady_clock::now();
+
+		// A segment created by someone else since the last index was picked is skipped, not truncated
+#ifdef _WIN32
+		while (true)
+		{
+			CurrentPath = SegmentPath(NextIndex++);
+			File = CreateFileA(CurrentPath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_NEW,
+				FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (File != INVALID_HANDLE_VALUE)
+			{
+				break;
+			}
+			if (GetLastError() != ERROR_FILE_EXISTS)
+			{
+				throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "Cannot create " + CurrentPath);
+			}
+		}
+
+		const ULONGLONG size = Options.SegmentBytes;
+		FileMapping = CreateFileMappingA(File, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr);
+		void* view = FileMapping != nullptr ? MapViewOfFile(FileMapping, FILE_MAP_WRITE, 0, 0, Options.SegmentBytes) : nullptr;
+		if (view == nullptr)
+		{
+			const DWORD mapError = GetLastError();
+			if (FileMapping != nullptr)
+			{
+				CloseHandle(FileMapping);
+			}
+			CloseHandle(File);
+			SetLastError(mapError);
+			throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "Cannot map " + CurrentPath);
+		}
+#else
+		while (true)
+		{
+			CurrentPath = SegmentPath(NextIndex++);
+			File = open(CurrentPath.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+			if (File >= 0)
+			{
+				break;
+			}
+			if (errno != EEXIST)
+			{
+				throw std::system_error(errno, std::generic_category(), "Cannot create " + CurrentPath);
+			}
+		}
+
+		// Reserve the blocks now: running out of disk space later would be a SIGBUS on a plain memcpy
+#ifdef __linux__
+		const int allocateError = posix_fallocate(File, 0, static_cast<off_t>(Options.SegmentBytes));
+#else
+		const int allocateError = ftruncate(File, static_cast<off_t>(Options.SegmentBytes)) == 0 ? 0 : errno;
+#endif
+		if (allocateError != 0)
+		{
+			close(File);
+			throw std::system_error(allocateError, std::generic_category(), "Cannot allocate " + CurrentPath);
+		}
+
+		void* view = mmap(nullptr, Options.SegmentBytes, PROT_READ | PROT_WRITE, MAP_SHARED, File, 0);
+		if (view == MAP_FAILED)
+		{
+			const int mapError = errno;
+			close(File);
+			errno = mapError;
+			throw std::system_error(errno, std::generic_category(), "Cannot map " + CurrentPath);
+		}
+#endif
+		Mapping = static_cast<char*>(view);
+	}
+
+	void CloseSegment()
+	{
+		if (Mapping == nullptr)
+		{
+			return;
+		}
+
+#ifdef _WIN32
+		UnmapViewOfFile(Mapping);
+		CloseHandle(FileMapping);
+
+		LARGE_INTEGER end;
+		end.QuadPart = static_cast<LONGLONG>(Used);
+		SetFilePointerEx(File, end, nullptr, FILE_BEGIN);
+		SetEndOfFile(File);
+		CloseHandle(File);
+#else
+		munmap(Mapping, Options.SegmentBytes);
+		if (ftruncate(File, static_cast<off_t>(Used)) != 0)
+		{
+			// The segment keeps its zero padding, nothing written is lost
+		}
+		close(File);
+#endif
+		Mapping = nullptr;
+	}
+
+	const FileSinkOptions Options;
+	std::size_t NextIndex;
+	std::string CurrentPath;
+	std::chrono::steady_clock::time_point SegmentStart;
+
+	char* Mapping = nullptr;
+	std::size_t Used = 0;
+#ifdef _WIN32
+	HANDLE File = INVALID_HANDLE_VALUE;
+	HANDLE FileMapping = nullptr;
+#else
+	int File = -1;
+#endif
+};
+
+// Bounded multi-producer multi-consumer queue (D. Vyukov's design).
+// Every slot carries a sequence number telling whose turn it is: producers claim a slot by advancing Tail
+// with a CAS, consumers by advancing Head, and nobody ever waits on a lock.
+template<typename T>
+class BoundedQueue
+{
+public:
+	// Capacity is rounded up to a power of two
+	explicit BoundedQueue(std::size_t InCapacity)
+	{
+		std::size_t capacity = 2;
+		while (capacity < InCapacity)
+		{
+			capacity *= 2;
+		}
+
+		Mask = capacity - 1;
+		Slots.reset(new Slot[capacity]);
+		for (std::size_t i = 0; i < capacity; ++i)
+		{
+			Slots[i].Sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	BoundedQueue(const BoundedQueue&) = delete;
+	BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+	// Returns false when the queue is full; Value is left untouched then
+	bool TryPush(T& Value)
+	{
+		std::size_t position = Tail.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Slot& slot = Slots[position & Mask];
+			const std::size_t sequence = slot.Sequence.load(std::memory_order_acquire);
+			const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+			if (difference == 0)
+			{
+				if (Tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					slot.Value = std::move(Value);
+					slot.Sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0)
+			{
+				return false;
+			}
+			else
+			{
+				position = Tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// Returns false when the queue is empty
+	bool TryPop(T& Value)
+	{
+		std::size_t position = Head.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Slot& slot = Slots[position & Mask];
+			const std::size_t sequence = slot.Sequence.load(std::memory_order_acquire);
+			const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+
+			if (difference == 0)
+			{
+				if (Head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					Value = std::move(slot.Value);
+					slot.Sequence.store(position + Mask + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0)
+			{
+				return false;
+			}
+			else
+			{
+				position = Head.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// True when nothing is ready to pop. Only a snapshot while other threads push or pop.
+	bool IsEmpty() const
+	{
+		std::size_t position = Head.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			const std::size_t sequence = Slots[position & Mask].Sequence.load(std::memory_order_acquire);
+			const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+			if (difference <= 0)
+			{
+				return difference < 0;
+			}
+			position = Head.load(std::memory_order_relaxed);
+		}
+	}
+
+private:
+	struct Slot
+	{
+		std::atomic<std::size_t> Sequence;
+		T Value;
+	};
+
+	std::unique_ptr<Slot[]> Slots;
+	std::size_t Mask = 0;
+
+	// Producers and consumers hammer different ends, keep them off each other's cache line
+	alignas(64) std::atomic<std::size_t> Tail{ 0 };
+	alignas(64) std::atomic<std::size_t> Head{ 0 };
+};
+
+// What Log does when the async queue is full
+enum class OverflowPolicy
+{
+	Block,		// wait for the background thread to make room
+	Drop,		// discard the new message
+	DropOldest	// discard the oldest queued message to make room for the new one
+};
+
+struct AsyncOptions
+{
+	std::size_t Capacity = 8192;
+	OverflowPolicy Overflow = OverflowPolicy::Block;
+	// Most messages the background thread joins into one sink write
+	std::size_t BatchSize = 256;
+};
+
+struct BufferedOptions
+{
+	// A thread whose staging buffer holds this many bytes asks for a flush
+	std::size_t FlushBytes = 64 * 1024;
+	// Everything staged is written at least this often
+	std::chrono::milliseconds FlushInterval{ 100 };
+};
+
+// Severity of a formatted record. Call sites below LOGGER_MIN_LEVEL are compiled out, arguments included.
+enum class LogLevel : int
+{
+	Trace = 0,
+	Debug = 1,
+	Info = 2,
+	Warning = 3,
+	Error = 4
+};
+
+#ifndef LOGGER_MIN_LEVEL
+#define LOGGER_MIN_LEVEL 2
+#endif
+
+constexpr LogLevel MinimumLogLevel = static_cast<LogLevel>(LOGGER_MIN_LEVEL);
+
+inline const char* LevelName(LogLevel Level)
+{
+	switch (Level)
+	{
+	case LogLevel::Trace: return "TRACE";
+	case LogLevel::Debug: return "DEBUG";
+	case LogLevel::Info: return "INFO";
+	case LogLevel::Warning: return "WARNING";
+	case LogLevel::Error: return "ERROR";
+	}
+	return "UNKNOWN";
+}
+
+struct FormatSite;
+
+// Every format site in the process, indexed by Id
+struct FormatDictionary
+{
+	std::mutex Mutex;
+	std::vector<const FormatSite*> Sites;
+};
+
+inline FormatDictionary& GetFormatDictionary()
+{
+	static FormatDictionary Dictionary;
+	return Dictionary;
+}
+
+// One LOGGER_LOG call site. Records carry only a pointer to it (or its Id, once written to a binary sink),
+// the format string itself is never copied.
+struct FormatSite
+{
+	FormatSite(LogLevel InLevel, const char* InFormat, const char* InFile, int InLine, bool InLeveled = true)
+		: Level(InLevel)
+		, Leveled(InLeveled)
+		, Format(InFormat)
+		, File(InFile)
+		, Line(InLine)
+	{
+		FormatDictionary& dictionary = GetFormatDictionary();
+		std::lock_guard<std::mutex> lock(dictionary.Mutex);
+		Id = static_cast<std::uint32_t>(dictionary.Sites.size());
+		dictionary.Sites.push_back(this);
+	}
+
+	FormatSite(const FormatSite&) = delete;
+	FormatSite& operator=(const FormatSite&) = delete;
+
+	const LogLevel Level;
+	// Logger::Log messages have no level and keep their original "Logger :message" look
+	const bool Leveled;
+	const char* const Format;
+	const char* const File;
+	const int Line;
+	std::uint32_t Id;
+};
+
+// Where Logger::Log(const std::string&) messages come from
+inline const FormatSite& PlainMessageSite()
+{
+	static const FormatSite Site(LogLevel::Info, "{}", __FILE__, __LINE__, false);
+	return Site;
+}
+
+// Encoded arguments of one record. Small records, the common case, fit inline and cost no allocation.
+class BinaryRecord
+{
+public:
+	void Append(const void* Bytes, std::size_t Count)
+	{
+		if (Overflow.empty() && Length + Count <= InlineCapacity)
+		{
+			std::memcpy(Inline + Length, Bytes, Count);
+		}
+		else
+		{
+			if (Overflow.empty())
+			{
+				Overflow.assign(Inline, Length);
+			}
+			Overflow.append(static_cast<const char*>(Bytes), Count);
+		}
+		Length += Count;
+	}
+
+	const char* Data() const { return Overflow.empty() ? Inline : Overflow.data(); }
+	std::size_t Size() const { return Length; }
+
+private:
+	static constexpr std::size_t InlineCapacity = 48;
+
+	std::size_t Length = 0;
+	char Inline[InlineCapacity];
+	// Holds the whole record once it outgrows Inline
+	std::string Overflow;
+};
+
+enum class ArgumentType : unsigned char
+{
+	Signed,
+	Unsigned,
+	Floating,
+	Boolean,
+	Character,
+	String
+};
+
+template<typename T>
+void EncodeValue(BinaryRecord& Record, ArgumentType Type, const T& Value)
+{
+	Record.Append(&Type, sizeof(Type));
+	Record.Append(&Value, sizeof(Value));
+}
+
+inline void EncodeArgument(BinaryRecord& Record, bool Value)
+{
+	EncodeValue(Record, ArgumentType::Boolean, Value);
+}
+
+inline void EncodeArgument(BinaryRecord& Record, char Value)
+{
+	EncodeValue(Record, ArgumentType::Character, Value);
+}
+
+template<typename T>
+std::enable_if_t<std::is_integral<T>::value && std::is_signed<T>::value> EncodeArgument(BinaryRecord& Record, T Value)
+{
+	EncodeValue(Record, ArgumentType::Signed, static_cast<std::int64_t>(Value));
+}
+
+template<typename T>
+std::enable_if_t<std::is_integral<T>::value && std::is_unsigned<T>::value> EncodeArgument(BinaryRecord& Record, T Value)
+{
+	EncodeValue(Record, ArgumentType::Unsigned, static_cast<std::uint64_t>(Value));
+}
+
+template<typename T>
+std::enable_if_t<std::is_floating_point<T>::value> EncodeArgument(BinaryRecord& Record, T Value)
+{
+	EncodeValue(Record, ArgumentType::Floating, static_cast<double>(Value));
+}
+
+inline void EncodeArgument(BinaryRecord& Record, std::string_view Value)
+{
+	EncodeValue(Record, ArgumentType::String, static_cast<std::uint32_t>(Value.size()));
+	Record.Append(Value.data(), Value.size());
+}
+
+inline void EncodeArgument(BinaryRecord& Record, const char* Value)
+{
+	EncodeArgument(Record, std::string_view(Value));
+}
+
+inline void EncodeArgument(BinaryRecord& Record, const std::string& Value)
+{
+	EncodeArgument(Record, std::string_view(Value));
+}
+
+template<typename... ArgumentTypes>
+void EncodeArguments(BinaryRecord& Record, const ArgumentTypes&... Arguments)
+{
+	(EncodeArgument(Record, Arguments), ...);
+}
+
+// Appends Format to Out with every {} replaced by the next encoded argument.
+// Missing arguments leave the {} in place, extra ones are ignored. Every read is checked against Size:
+// on a corrupt record the remaining {} stay as they are and false is returned.
+inline bool FormatArguments(const char* Format, const char* Data, std::size_t Size, std::string& Out)
+{
+	const char* const end = Data + Size;
+	bool valid = true;
+	auto read = [&Data, end](void* Value, std::size_t Count)
+		{
+			if (static_cast<std::size_t>(end - Data) < Count)
+			{
+				return false;
+			}
+			std::memcpy(Value, Data, Count);
+			Data += Count;
+			return true;
+		};
+
+	for (const char* current = Format; *current != '\0'; ++current)
+	{
+		if (current[0] != '{' || current[1] != '}' || Data == end)
+		{
+			Out += *current;
+			continue;
+		}
+		++current;
+
+		const ArgumentType type = static_cast<ArgumentType>(static_cast<unsigned char>(*Data++));
+
+		char number[32];
+		bool decoded = false;
+		switch (type)
+		{
+		case ArgumentType::Signed:
+		{
+			std::int64_t value;
+			if ((decoded = read(&value, sizeof(value))))
+			{
+				Out += std::to_string(value);
+			}
+			break;
+		}
+		case ArgumentType::Unsigned:
+		{
+			std::uint64_t value;
+			if ((decoded = read(&value, sizeof(value))))
+			{
+				Out += std::to_string(value);
+			}
+			break;
+		}
+		case ArgumentType::Floating:
+		{
+			double value;
+			if ((decoded = read(&value, sizeof(value))))
+			{
+				std::snprintf(number, sizeof(number), "%g", value);
+				Out += number;
+			}
+			break;
+		}
+		case ArgumentType::Boolean:
+		{
+			unsigned char value;
+			if ((decoded = read(&value, sizeof(value))))
+			{
+				Out += value != 0 ? "true" : "false";
+			}
+			break;
+		}
+		case ArgumentType::Character:
+		{
+			char value;
+			if ((decoded = read(&value, sizeof(value))))
+			{
+				Out += value;
+			}
+			break;
+		}
+		case ArgumentType::String:
+		{
+			std::uint32_t length;
+			if ((decoded = read(&length, sizeof(length)) && static_cast<std::size_t>(end - Data) >= length))
+			{
+				Out.append(Data, length);
+				Data += length;
+			}
+			break;
+		}
+		}
+
+		if (!decoded)
+		{
+			// Corrupt record, print the rest of the format as is
+			valid = false;
+			Data = end;
+			Out += "{}";
+		}
+	}
+	return valid;
+}
+
+// Returns false if the arguments were corrupt, see FormatArguments
+inline bool AppendTextLine(bool Leveled, LogLevel Level, const char* Format, const char* Data, std::size_t Size, std::string& Out)
+{
+	Out += "Logger :";
+	if (Leveled)
+	{
+		Out += '[';
+		Out += LevelName(Level);
+		Out += "] ";
+	}
+	const bool valid = FormatArguments(Format, Data, Size, Out);
+	Out += '\n';
+	return valid;
+}
+
+// What the logger moves between threads: the call site plus the encoded arguments, not yet formatted
+struct LogRecord
+{
+	const FormatSite* Site = nullptr;
+	BinaryRecord Arguments;
+};
+
+// Appends Record to Out as a text line or, for a binary sink, as a frame
+inline void AppendRecord(const LogRecord& Record, bool Binary, std::string& Out)
+{
+	if (!Binary)
+	{
+		AppendTextLine(Record.Site->Leveled, Record.Site->Level, Record.Site->Format,
+			Record.Arguments.Data(), Record.Arguments.Size(), Out);
+		return;
+	}
+
+	const std::uint32_t header[2] = { Record.Site->Id, static_cast<std::uint32_t>(Record.Arguments.Size()) };
+	Out.append(reinterpret_cast<const char*>(header), sizeof(header));
+	Out.append(Record.Arguments.Data(), Record.Arguments.Size());
+}
+
+// Keeps track of every Singleton<T> instance in creation order. ShutdownAll destroys them newest first,
+// so a singleton that used another one while it was created goes away before it.
+// Whatever is still alive is shut down the same way when the program exits.
+class SingletonRegistry
+{
+public:
+	static void Register(void (*Destroy)())
+	{
+		State& state = GetState();
+		std::lock_guard<std::mutex> lock(state.Mutex);
+		state.Destroyers.push_back(Destroy);
+	}
+
+	// For an instance destroyed early; if it is created again it registers anew, as the newest
+	static void Unregister(void (*Destroy)())
+	{
+		State& state = GetState();
+		std::lock_guard<std::mutex> lock(state.Mutex);
+		auto registered = std::find(state.Destroyers.rbegin(), state.Destroyers.rend(), Destroy);
+		if (registered != state.Destroyers.rend())
+		{
+			state.Destroyers.erase(std::next(registered).base());
+		}
+	}
+
+	static std::size_t GetCount()
+	{
+		State& state = GetState();
+		std::lock_guard<std::mutex> lock(state.Mutex);
+		return state.Destroyers.size();
+	}
+
+	// Call only when no other thread is using any singleton
+	static void ShutdownAll()
+	{
+		State& state = GetState();
+		for (;;)
+		{
+			void (*destroy)() = nullptr;
+			{
+				std::lock_guard<std::mutex> lock(state.Mutex);
+				if (state.Destroyers.empty())
+				{
+					return;
+				}
+				destroy = state.Destroyers.back();
+				state.Destroyers.pop_back();
+			}
+			// Outside the lock, a destructor may use (and so register) another singleton
+			destroy();
+		}
+	}
+
+private:
+	struct State
+	{
+		~State() { ShutdownAll(); }
+
+		std::mutex Mutex;
+		std::vector<void (*)()> Destroyers;
+	};
+
+	static State& GetState()
+	{
+		static State Instance;
+		return Instance;
+	}
+};
+
+// Lazily created single instance of T. Get() is one acquire load and a branch once T exists; creation takes a
+// mutex, once. The storage is static and constant-initialized, so there is no heap indirection and no
+// initialization order problem. T may keep its constructor private and befriend Singleton<T>.
+template<typename T>
+class Singleton
+{
+public:
+	static T& Get()
+	{
+		T* instance = Instance.load(std::memory_order_acquire);
+		if (instance != nullptr)
+		{
+			return *instance;
+		}
+		return Create();
+	}
+
+	static bool IsAlive()
+	{
+		return Instance.load(std::memory_order_acquire) != nullptr;
+	}
+
+	// Destroys the instance now; a later Get() creates a new one. Same rules as SingletonRegistry::ShutdownAll.
+	static void Destroy()
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		T* instance = Instance.load(std::memory_order_relaxed);
+		if (instance != nullptr)
+		{
+			SingletonRegistry::Unregister(&Singleton<T>::Destroy);
+			Instance.store(nullptr, std::memory_order_release);
+			instance->~T();
+		}
+	}
+
+private:
+	static T& Create()
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		T* instance = Instance.load(std::memory_order_relaxed);
+		if (instance == nullptr)
+		{
+			instance = ::new (static_cast<void*>(Storage)) T();
+			SingletonRegistry::Register(&Singleton<T>::Destroy);
+			Instance.store(instance, std::memory_order_release);
+		}
+		return *instance;
+	}
+
+	alignas(T) static inline unsigned char Storage[sizeof(T)];
+	static inline std::atomic<T*> Instance{ nullptr };
+	static inline std::mutex Mutex;
+};
+
+class Logger
+{
+public:
+	static Logger& GetInstance()
+	{
+		return Singleton<Logger>::Get();
+	}
+
+	~Logger()
+	{
+		StopAsync();
+	}
+
+	void Log(const std::string& MessageToLog)
+	{
+		LogRecord record;
+		record.Site = &PlainMessageSite();
+		EncodeArgument(record.Arguments, MessageToLog);
+		Submit(std::move(record));
+	}
+
+	// Captures the arguments in binary form; formatting happens wherever the record is written.
+	// Use it through LOGGER_LOG and friends, which also provide the Site.
+	template<typename... ArgumentTypes>
+	void LogFormat(const FormatSite& Site, const ArgumentTypes&... Arguments)
+	{
+		LogRecord record;
+		record.Site = &Site;
+		EncodeArguments(record.Arguments, Arguments...);
+		Submit(std::move(record));
+	}
+
+	// SetSink, StartAsync, StartBuffered and StopAsync switch the logger's mode:
+	// call them while no other thread is logging
+	void SetSink(std::unique_ptr<LogSink> NewSink)
+	{
+		const bool wasAsync = AsyncBackend != nullptr;
+		const bool wasBuffered = BufferedBackend != nullptr;
+		const AsyncOptions asyncOptions = wasAsync ? AsyncBackend->Options : AsyncOptions();
+		const BufferedOptions bufferedOptions = wasBuffered ? BufferedBackend->Options : BufferedOptions();
+
+		StopAsync();
+		Sink = std::move(NewSink);
+		if (wasAsync)
+		{
+			StartAsync(asyncOptions);
+		}
+		else if (wasBuffered)
+		{
+			StartBuffered(bufferedOptions);
+		}
+	}
+
+	// From now on Log only queues the message, a background thread writes it
+	void StartAsync(const AsyncOptions& Options = AsyncOptions())
+	{
+		StopAsync();
+		AsyncBackend.reset(new AsyncWriter(*Sink, Mtx, Options));
+	}
+
+	// From now on Log appends the message to a buffer of the calling thread. A background thread merges
+	// all buffers into one chronological chunk per flush. No structure is shared between logging threads.
+	void StartBuffered(const BufferedOptions& Options = BufferedOptions())
+	{
+		StopAsync();
+		BufferedBackend.reset(new BufferedWriter(*Sink, Mtx, Options));
+	}
+
+	// Writes out everything queued or staged and goes back to synchronous logging
+	void StopAsync()
+	{
+		AsyncBackend.reset();
+		BufferedBackend.reset();
+		Sink->Flush();
+	}
+
+	bool IsAsync() const { return AsyncBackend != nullptr; }
+	bool IsBuffered() const { return BufferedBackend != nullptr; }
+
+	// Returns once every message logged before the call has reached the sink
+	void Flush()
+	{
+		if (AsyncBackend != nullptr)
+		{
+			AsyncBackend->WaitUntilWritten();
+		}
+
+		if (BufferedBackend != nullptr)
+		{
+			BufferedBackend->FlushStaged();
+		}
+
+		std::lock_guard<std::mutex> lock(Mtx);
+		Sink->Flush();
+	}
+
+	// Messages lost to OverflowPolicy::Drop or DropOldest since StartAsync
+	std::uint64_t GetDroppedCount() const
+	{
+		return AsyncBackend != nullptr ? AsyncBackend->Dropped.load(std::memory_order_relaxed) : 0;
+	}
+
+private:
+	friend class Singleton<Logger>;
+
+	Logger() : Sink(new ConsoleSink()) {}
+
+	Logger(const Logger&) = delete;
+	Logger& operator=(const Logger&) = delete;
+
+	void Submit(LogRecord&& Record)
+	{
+		if (AsyncBackend != nullptr)
+		{
+			AsyncBackend->Push(std::move(Record));
+			return;
+		}
+
+		if (BufferedBackend != nullptr)
+		{
+			BufferedBackend->Stage(std::move(Record));
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(Mtx);
+		Line.clear();
+		AppendRecord(Record, Sink->IsBinary(), Line);
+		Sink->Write(Line);
+		Sink->Flush();
+	}
+
+	// The queue plus the thread draining it into the sink
+	class AsyncWriter
+	{
+	public:
+		AsyncWriter(LogSink& InSink, std::mutex& InSinkMutex, const AsyncOptions& InOptions)
+			: Options(InOptions)
+			, Sink(InSink)
+			, SinkMutex(InSinkMutex)
+			, Queue(InOptions.Capacity)
+			, Worker([this]() { Drain(); })
+		{
+		}
+
+		~AsyncWriter()
+		{
+			Running.store(false, std::memory_order_release);
+			WakeWorker();
+			Worker.join();
+		}
+
+		void Push(LogRecord Record)
+		{
+			while (!Queue.TryPush(Record))
+			{
+				if (Options.Overflow == OverflowPolicy::Drop)
+				{
+					Dropped.fetch_add(1, std::memory_order_relaxed);
+					return;
+				}
+
+				if (Options.Overflow == OverflowPolicy::DropOldest)
+				{
+					LogRecord oldest;
+					if (Queue.TryPop(oldest))
+					{
+						Dropped.fetch_add(1, std::memory_order_relaxed);
+						Processed.fetch_add(1, std::memory_order_release);
+					}
+				}
+				else
+				{
+					WakeWorker();
+					std::this_thread::yield();
+				}
+			}
+
+			Accepted.fetch_add(1, std::memory_order_relaxed);
+			// Pairs with the fence in Drain: either the worker sees this record or we see it going to sleep
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (WorkerSleeping.load(std::memory_order_seq_cst))
+			{
+				WakeWorker();
+			}
+		}
+
+		void WaitUntilWritten()
+		{
+			const std::uint64_t target = Accepted.load(std::memory_order_relaxed);
+			while (Processed.load(std::memory_order_acquire) < target)
+			{
+				WakeWorker();
+				std::this_thread::yield();
+			}
+		}
+
+		const AsyncOptions Options;
+		std::atomic<std::uint64_t> Dropped{ 0 };
+
+	private:
+		void Drain()
+		{
+			const bool binary = Sink.IsBinary();
+			std::string batch;
+			LogRecord record;
+			for (;;)
+			{
+				const bool stopping = !Running.load(std::memory_order_acquire);
+
+				batch.clear();
+				std::size_t count = 0;
+				while (count < Options.BatchSize && Queue.TryPop(record))
+				{
+					AppendRecord(record, binary, batch);
+					++count;
+				}
+
+				if (count > 0)
+				{
+					{
+						std::lock_guard<std::mutex> lock(SinkMutex);
+						Sink.Write(batch);
+					}
+					Processed.fetch_add(count, std::memory_order_release);
+					continue;
+				}
+
+				if (stopping)
+				{
+					return;
+				}
+
+				// Producers only take the mutex to wake us when they see this flag. A record pushed before they
+				// could see it is caught by the check after the fence, so there is no timeout to poll with.
+				std::unique_lock<std::mutex> lock(WakeMutex);
+				WorkerSleeping.store(true, std::memory_order_seq_cst);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				WakeCondition.wait(lock, [this]() { return !Queue.IsEmpty() || !Running.load(std::memory_order_acquire); });
+				WorkerSleeping.store(false, std::memory_order_relaxed);
+			}
+		}
+
+		void WakeWorker()
+		{
+			std::lock_guard<std::mutex> lock(WakeMutex);
+			WakeCondition.notify_one();
+		}
+
+		LogSink& Sink;
+		// The Logger's mutex, Flush touches the sink from other threads
+		std::mutex& SinkMutex;
+		BoundedQueue<LogRecord> Queue;
+
+		std::atomic<bool> Running{ true };
+		std::atomic<bool> WorkerSleeping{ false };
+		std::atomic<std::uint64_t> Accepted{ 0 };
+		std::atomic<std::uint64_t> Processed{ 0 };
+		std::mutex WakeMutex;
+		std::condition_variable WakeCondition;
+
+		// Started last, once everything it uses is constructed
+		std::thread Worker;
+	};
+
+	// Per-thread staging buffers plus the thread that periodically merges them into the sink
+	class BufferedWriter
+	{
+	public:
+		BufferedWriter(LogSink& InSink, std::mutex& InSinkMutex, const BufferedOptions& InOptions)
+			: Options(InOptions)
+			, Sink(InSink)
+			, SinkMutex(InSinkMutex)
+			, Id(NextId().fetch_add(1) + 1)
+			, Worker([this]() { FlushPeriodically(); })
+		{
+		}
+
+		~BufferedWriter()
+		{
+			{
+				std::lock_guard<std::mutex> lock(WakeMutex);
+				Running = false;
+			}
+			WakeCondition.notify_one();
+			Worker.join();
+
+			FlushStaged();
+		}
+
+		void Stage(LogRecord&& Entry)
+		{
+			ThreadBuffer& buffer = LocalBuffer();
+
+			bool full = false;
+			{
+				// Only a flush ever competes for this lock. Taking the timestamp under it keeps
+				// every buffer sorted and lets FlushStaged cut all buffers at one point in time.
+				std::lock_guard<std::mutex> lock(buffer.Mutex);
+				buffer.Bytes += Entry.Arguments.Size();
+				buffer.Records.push_back(Record{ Now(), std::move(Entry) });
+				full = buffer.Bytes >= Options.FlushBytes;
+			}
+
+			if (full && !FlushRequested.exchange(true))
+			{
+				std::lock_guard<std::mutex> lock(WakeMutex);
+				WakeCondition.notify_one();
+			}
+		}
+
+		// Writes every record staged before the call, in timestamp order, with one sink write
+		void FlushStaged()
+		{
+			std::lock_guard<std::mutex> flushLock(FlushMutex);
+			FlushRequested.store(false);
+
+			// Records stamped after the cutoff stay staged for the next flush. A record stamped before it is
+			// already in its buffer once we get that buffer's lock, so nothing older can show up later.
+			const std::uint64_t cutoff = Now();
+			Merged.clear();
+
+			std::lock_guard<std::mutex> registryLock(RegistryMutex);
+			for (auto it = Buffers.begin(); it != Buffers.end();)
+			{
+				ThreadBuffer& buffer = **it;
+				// Checked before draining: a thread may stage more records after we let go of its buffer and exit
+				// right after, only a thread that was already gone has nothing more coming
+				const bool exited = it->use_count() == 1;
+				bool drained = false;
+				{
+					std::lock_guard<std::mutex> lock(buffer.Mutex);
+
+					auto firstKept = std::upper_bound(buffer.Records.begin(), buffer.Records.end(), cutoff,
+						[](std::uint64_t Time, const Record& Other) { return Time < Other.Timestamp; });
+					for (auto record = buffer.Records.begin(); record != firstKept; ++record)
+					{
+						buffer.Bytes -= record->Entry.Arguments.Size();
+						Merged.push_back(std::move(*record));
+					}
+					buffer.Records.erase(buffer.Records.begin(), firstKept);
+					drained = buffer.Records.empty();
+				}
+
+				// The thread has exited and everything it logged is out
+				if (drained && exited)
+				{
+					it = Buffers.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+
+			if (Merged.empty())
+			{
+				return;
+			}
+
+			std::stable_sort(Merged.begin(), Merged.end(),
+				[](const Record& Left, const Record& Right) { return Left.Timestamp < Right.Timestamp; });
+
+			const bool binary = Sink.IsBinary();
+			Chunk.clear();
+			for (const Record& record : Merged)
+			{
+				AppendRecord(record.Entry, binary, Chunk);
+			}
+
+			std::lock_guard<std::mutex> sinkLock(SinkMutex);
+			Sink.Write(Chunk);
+		}
+
+		const BufferedOptions Options;
+
+	private:
+		struct Record
+		{
+			std::uint64_t Timestamp;
+			LogRecord Entry;
+		};
+
+		struct ThreadBuffer
+		{
+			std::mutex Mutex;
+			std::vector<Record> Records;
+			std::size_t Bytes = 0;
+		};
+
+		static std::atomic<std::uint64_t>& NextId()
+		{
+			static std::atomic<std::uint64_t> Counter(0);
+			return Counter;
+		}
+
+		static std::uint64_t Now()
+		{
+			return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count());
+		}
+
+		// The calling thread's buffer, created and registered on its first message.
+		// Writers are told apart by Id rather than address, a new writer may reuse an old one's memory.
+		ThreadBuffer& LocalBuffer()
+		{
+			struct Cache
+			{
+				std::uint64_t WriterId = 0;
+				std::shared_ptr<ThreadBuffer> Buffer;
+			};
+			thread_local Cache cache;
+
+			if (cache.WriterId != Id)
+			{
+				cache.Buffer = std::make_shared<ThreadBuffer>();
+				cache.WriterId = Id;
+
+				std::lock_guard<std::mutex> lock(RegistryMutex);
+				Buffers.push_back(cache.Buffer);
+			}
+			return *cache.Buffer;
+		}
+
+		void FlushPeriodically()
+		{
+			std::unique_lock<std::mutex> lock(WakeMutex);
+			while (Running)
+			{
+				WakeCondition.wait_for(lock, Options.FlushInterval, [this]() { return !Running || FlushRequested.load(); });
+
+				lock.unlock();
+				FlushStaged();
+				lock.lock();
+			}
+		}
+
+		LogSink& Sink;
+		std::mutex& SinkMutex;
+		const std::uint64_t Id;
+
+		std::mutex RegistryMutex;
+		std::vector<std::shared_ptr<ThreadBuffer>> Buffers;
+
+		// Serializes flushes, their cutoffs must be written in order. Merged and Chunk are reused between them.
+		std::mutex FlushMutex;
+		std::vector<Record> Merged;
+		std::string Chunk;
+
+		bool Running = true;
+		std::atomic<bool> FlushRequested{ false };
+		std::mutex WakeMutex;
+		std::condition_variable WakeCondition;
+
+		// Started last, once everything it uses is constructed
+		std::thread Worker;
+	};
+
+private:
+	std::mutex Mtx;
+	std::unique_ptr<LogSink> Sink;
+	// Reused by synchronous writes, guarded by Mtx
+	std::string Line;
+	std::unique_ptr<AsyncWriter> AsyncBackend;
+	std::unique_ptr<BufferedWriter> BufferedBackend;
+};
+
+// LOGGER_INFO("loaded {} of {} files", loaded, total);
+// Below LOGGER_MIN_LEVEL the whole statement compiles to nothing, the arguments are not even evaluated.
+#define LOGGER_LOG(Level, Format, ...) \
+	do \
+	{ \
+		if constexpr ((Level) >= ::Singleton::MinimumLogLevel) \
+		{ \
+			static const ::Singleton::FormatSite LoggerFormatSite((Level), Format, __FILE__, __LINE__); \
+			::Singleton::Logger::GetInstance().LogFormat(LoggerFormatSite, ##__VA_ARGS__); \
+		} \
+	} while (false)
+
+#define LOGGER_TRACE(Format, ...) LOGGER_LOG(::Singleton::LogLevel::Trace, Format, ##__VA_ARGS__)
+#define LOGGER_DEBUG(Format, ...) LOGGER_LOG(::Singleton::LogLevel::Debug, Format, ##__VA_ARGS__)
+#define LOGGER_INFO(Format, ...) LOGGER_LOG(::Singleton::LogLevel::Info, Format, ##__VA_ARGS__)
+#define LOGGER_WARNING(Format, ...) LOGGER_LOG(::Singleton::LogLevel::Warning, Format, ##__VA_ARGS__)
+#define LOGGER_ERROR(Format, ...) LOGGER_LOG(::Singleton::LogLevel::Error, Format, ##__VA_ARGS__)
+
+// Dictionary fields are separated by tabs and lines by newlines, so both are escaped inside a field
+inline std::string EscapeDictionaryField(std::string_view Field)
 {
-public:
-	static Logger& GetInstance()
+	std::string escaped;
+	for (char character : Field)
 	{
-		std::call_once(InitInstanceFlag, []()
-			{
-				LoggerInstance.reset(new Logger());
-			});
+		switch (character)
+		{
+		case '\\': escaped += "\\\\"; break;
+		case '\t': escaped += "\\t"; break;
+		case '\n': escaped += "\\n"; break;
+		case '\r': escaped += "\\r"; break;
+		default: escaped += character; break;
+		}
+	}
+	return escaped;
+}
 
-		return *LoggerInstance;
+// False on an escape EscapeDictionaryField does not write
+inline bool UnescapeDictionaryField(std::string_view Field, std::string& Out)
+{
+	Out.clear();
+	for (std::size_t i = 0; i < Field.size(); ++i)
+	{
+		if (Field[i] != '\\')
+		{
+			Out += Field[i];
+			continue;
+		}
+		if (++i == Field.size())
+		{
+			return false;
+		}
+		switch (Field[i])
+		{
+		case '\\': Out += '\\'; break;
+		case 't': Out += '\t'; break;
+		case 'n': Out += '\n'; break;
+		case 'r': Out += '\r'; break;
+		default: return false;
+		}
 	}
+	return true;
+}
 
-	void Log(const std::string& MessageToLog)
+// Saves every format site seen so far, one per line: id, level (-1 for plain messages), file:line, format.
+// Site ids are handed out at run time, so a binary log can only be decoded with the dictionary of its own run.
+inline void WriteFormatDictionary(std::ostream& Out)
+{
+	FormatDictionary& dictionary = GetFormatDictionary();
+	std::lock_guard<std::mutex> lock(dictionary.Mutex);
+	for (const FormatSite* site : dictionary.Sites)
 	{
-		std::lock_guard<std::mutex> lock(Mtx);
-		std::cout << "Logger :" << MessageToLog << std::endl;
+		Out << site->Id << '\t' << (site->Leveled ? static_cast<int>(site->Level) : -1) << '\t'
+			<< EscapeDictionaryField(site->File) << ':' << site->Line << '\t' << EscapeDictionaryField(site->Format) << '\n';
 	}
+}
 
-private:
-	Logger() = default;
+// Turns the output of a BinaryStreamSink back into the text the logger would have written.
+// Returns false on a malformed dictionary line, a record the dictionary does not know, a corrupt record
+// or a truncated file.
+inline bool DecodeBinaryLog(std::istream& Dictionary, std::istream& Records, std::ostream& Out)
+{
+	struct DecodedSite
+	{
+		int Level;
+		std::string Format;
+	};
 
-	Logger(const Logger&) = delete;
-	Logger& operator=(const Logger&) = delete;
+	std::unordered_map<std::uint32_t, DecodedSite> sites;
+	std::string line;
+	while (std::getline(Dictionary, line))
+	{
+		const std::size_t idEnd = line.find('\t');
+		if (idEnd == std::string::npos)
+		{
+			return false;
+		}
+		const std::size_t levelEnd = line.find('\t', idEnd + 1);
+		if (levelEnd == std::string::npos)
+		{
+			return false;
+		}
+		const std::size_t locationEnd = line.find('\t', levelEnd + 1);
+		if (locationEnd == std::string::npos)
+		{
+			return false;
+		}
 
-private:
-    static std::unique_ptr<Logger> LoggerInstance;
-    static std::once_flag InitInstanceFlag;
+		std::uint32_t id;
+		DecodedSite site;
+		const char* const text = line.data();
+		const std::from_chars_result idResult = std::from_chars(text, text + idEnd, id);
+		const std::from_chars_result levelResult = std::from_chars(text + idEnd + 1, text + levelEnd, site.Level);
+		if (idResult.ec != std::errc() || idResult.ptr != text + idEnd
+			|| levelResult.ec != std::errc() || levelResult.ptr != text + levelEnd
+			|| site.Level < -1 || site.Level > static_cast<int>(LogLevel::Error)
+			|| !UnescapeDictionaryField(std::string_view(line).substr(locationEnd + 1), site.Format))
+		{
+			return false;
+		}
+		sites[id] = std::move(site);
+	}
 
-	std::mutex Mtx;
-};
+	std::string payload;
+	std::string text;
+	std::uint32_t header[2];
+	while (Records.read(reinterpret_cast<char*>(header), sizeof(header)))
+	{
+		auto site = sites.find(header[0]);
+		if (site == sites.end())
+		{
+			return false;
+		}
+
+		// Grown as the bytes arrive, so a corrupt size costs at most one chunk more than the stream holds
+		const std::size_t size = header[1];
+		payload.clear();
+		while (payload.size() < size)
+		{
+			const std::size_t offset = payload.size();
+			const std::size_t chunk = std::min<std::size_t>(size - offset, 64 * 1024);
+			payload.resize(offset + chunk);
+			if (!Records.read(&payload[offset], static_cast<std::streamsize>(chunk)))
+			{
+				return false;
+			}
+		}
 
-std::unique_ptr<Logger> Logger::LoggerInstance;
-std::once_flag Logger::InitInstanceFlag;
+		text.clear();
+		const bool leveled = site->second.Level >= 0;
+		if (!AppendTextLine(leveled, static_cast<LogLevel>(leveled ? site->second.Level : 0), site->second.Format.c_str(),
+			payload.data(), payload.size(), text))
+		{
+			return false;
+		}
+		Out << text;
+	}
+	return Records.gcount() == 0;
+}
 
 void TestSingletonPattern()
 {
@@ -63,4 +1564,723 @@ void TestSingletonPattern()
 	}
 }
 
-} // namespace Singleton
+// Holds the background thread inside Write until released, so the queue can be filled up on purpose
+class GateSink : public LogSink
+{
+public:
+	explicit GateSink(std::ostream& InStream) : Stream(InStream) {}
+
+	void Write(const std::string& Lines) override
+	{
+		while (!Open.load())
+		{
+			std::this_thread::yield();
+		}
+		Stream << Lines;
+	}
+
+	std::atomic<bool> Open{ false };
+
+private:
+	std::ostream& Stream;
+};
+
+std::size_t CountLines(const std::string& Text)
+{
+	return static_cast<std::size_t>(std::count(Text.begin(), Text.end(), '\n'));
+}
+
+void TestAsyncLogger()
+{
+	Logger& logger = Logger::GetInstance();
+
+	// Every message from every thread arrives exactly once
+	{
+		std::ostringstream out;
+		logger.SetSink(std::unique_ptr<LogSink>(new StreamSink(out)));
+
+		AsyncOptions options;
+		options.Capacity = 64;
+		logger.StartAsync(options);
+
+		const int threads = 4;
+		const int messagesPerThread = 1000;
+		std::vector<std::thread> producers;
+		for (int t = 0; t < threads; ++t)
+		{
+			producers.emplace_back([&logger, t, messagesPerThread]()
+				{
+					for (int i = 0; i < messagesPerThread; ++i)
+					{
+						logger.Log(std::to_string(t) + ":" + std::to_string(i));
+					}
+				});
+		}
+		for (std::thread& producer : producers)
+		{
+			producer.join();
+		}
+
+		logger.Flush();
+		assert(CountLines(out.str()) == threads * messagesPerThread);
+		assert(out.str().find("Logger :3:999\n") != std::string::npos);
+		assert(logger.GetDroppedCount() == 0);
+		logger.StopAsync();
+		logger.SetSink(std::unique_ptr<LogSink>(new ConsoleSink()));
+	}
+
+	// Drop and DropOldest lose messages instead of waiting, DropOldest keeps the newest
+	for (OverflowPolicy policy : { OverflowPolicy::Drop, OverflowPolicy::DropOldest })
+	{
+		std::ostringstream out;
+		GateSink* gate = new GateSink(out);
+		logger.SetSink(std::unique_ptr<LogSink>(gate));
+
+		AsyncOptions options;
+		options.Capacity = 8;
+		options.Overflow = policy;
+		logger.StartAsync(options);
+
+		const int messages = 100;
+		for (int i = 0; i < messages; ++i)
+		{
+			logger.Log(std::to_string(i));
+		}
+		gate->Open.store(true);
+		logger.Flush();
+
+		assert(logger.GetDroppedCount() > 0);
+		assert(CountLines(out.str()) + logger.GetDroppedCount() == messages);
+		if (policy == OverflowPolicy::DropOldest)
+		{
+			assert(out.str().find("Logger :99\n") != std::string::npos);
+		}
+		logger.StopAsync();
+		logger.SetSink(std::unique_ptr<LogSink>(new ConsoleSink()));
+	}
+
+	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+void TestBufferedLogger()
+{
+	Logger& logger = Logger::GetInstance();
+
+	// All messages arrive, each thread's in the order it logged them
+	{
+		std::ostringstream out;
+		logger.SetSink(std::unique_ptr<LogSink>(new StreamSink(out)));
+
+		BufferedOptions options;
+		options.FlushBytes = 256;
+		logger.StartBuffered(options);
+
+		const int threads = 4;
+		const int messagesPerThread = 1000;
+		std::vector<std::thread> producers;
+		for (int t = 0; t < threads; ++t)
+		{
+			producers.emplace_back([&logger, t, messagesPerThread]()
+				{
+					for (int i = 0; i < messagesPerThread; ++i)
+					{
+						logger.Log(std::to_string(t) + ":" + std::to_string(i));
+					}
+				});
+		}
+		for (std::thread& producer : producers)
+		{
+			producer.join();
+		}
+		logger.Flush();
+
+		const std::string text = out.str();
+		assert(CountLines(text) == threads * messagesPerThread);
+		for (int t = 0; t < threads; ++t)
+		{
+			[[maybe_unused]] std::size_t previous = 0;
+			for (int i = 0; i < messagesPerThread; ++i)
+			{
+				const std::size_t position = text.find("Logger :" + std::to_string(t) + ":" + std::to_string(i) + "\n");
+				assert(position != std::string::npos && (i == 0 || position > previous));
+				previous = position;
+			}
+		}
+		logger.StopAsync();
+		logger.SetSink(std::unique_ptr<LogSink>(new ConsoleSink()));
+	}
+
+	// Messages of different threads are merged in the order they were logged
+	{
+		std::ostringstream out;
+		logger.SetSink(std::unique_ptr<LogSink>(new StreamSink(out)));
+		logger.StartBuffered();
+
+		logger.Log("first");
+		std::thread second([&logger]() { logger.Log("second"); });
+		second.join();
+		logger.Log("third");
+		logger.Flush();
+
+		assert(out.str() == "Logger :first\nLogger :second\nLogger :third\n");
+		logger.StopAsync();
+		logger.SetSink(std::unique_ptr<LogSink>(new ConsoleSink()));
+	}
+
+	// Staged messages are written without an explicit flush once the interval passes
+	{
+		class CountingSink : public LogSink
+		{
+		public:
+			void Write(const std::string& Lines) override { WrittenLines.fetch_add(CountLines(Lines)); }
+
+			std::atomic<std::size_t> WrittenLines{ 0 };
+		};
+
+		CountingSink* sink = new CountingSink();
+		logger.SetSink(std::unique_ptr<LogSink>(sink));
+
+		BufferedOptions options;
+		options.FlushInterval = std::chrono::milliseconds(1);
+		logger.StartBuffered(options);
+		logger.Log("timed");
+
+		for (int attempt = 0; attempt < 1000 && sink->WrittenLines.load() == 0; ++attempt)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		assert(sink->WrittenLines.load() == 1);
+		logger.StopAsync();
+		logger.SetSink(std::unique_ptr<LogSink>(new ConsoleSink()));
+	}
+
+	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+void TestFormattedLogger()
+{
+	Logger& logger = Logger::GetInstance();
+
+	const std::string longText(100, 'x');
+	const std::string expected =
+		"Logger :[INFO] int -3 unsigned 7 double 2.5 bool true char c text abc\n" +
+		std::string(MinimumLogLevel <= LogLevel::Debug ? "Logger :[DEBUG] compiled out below LOGGER_MIN_LEVEL 1\n" : "") +
+		"Logger :[ERROR] long " + longText + " {}\n"
+		"Logger :plain\n";
+
+	auto logAll = [&logger, &longText]()
+		{
+			LOGGER_INFO("int {} unsigned {} double {} bool {} char {} text {}", -3, 7u, 2.5, true, 'c', "abc");
+			LOGGER_DEBUG("compiled out below LOGGER_MIN_LEVEL {}", 1);
+			LOGGER_ERROR("long {} {}", longText);
+			logger.Log("plain");
+		};
+
+	// Formatted on the logging thread
+	{
+		std::ostringstream out;
+		logger.SetSink(std::unique_ptr<LogSink>(new StreamSink(out)));
+		logAll();
+		assert(out.str() == expected);
+		logger.SetSink(std::unique_ptr<LogSink>(new ConsoleSink()));
+	}
+
+	// Formatted on the background thread
+	{
+		std::ostringstream out;
+		logger.SetSink(std::unique_ptr<LogSink>(new StreamSink(out)));
+		logger.StartAsync();
+		logAll();
+		logger.Flush();
+		assert(out.str() == expected);
+		logger.StopAsync();
+		logger.SetSink(std::unique_ptr<LogSink>(new ConsoleSink()));
+	}
+
+	// Not formatted at all until decoded
+	{
+		std::ostringstream records(std::ios::binary);
+		logger.SetSink(std::unique_ptr<LogSink>(new BinaryStreamSink(records)));
+		logger.StartBuffered();
+		logAll();
+		logger.Flush();
+		logger.StopAsync();
+		logger.SetSink(std::unique_ptr<LogSink>(new ConsoleSink()));
+
+		std::stringstream dictionary;
+		WriteFormatDictionary(dictionary);
+
+		std::istringstream recordsIn(records.str(), std::ios::binary);
+		std::ostringstream decoded;
+		assert(DecodeBinaryLog(dictionary, recordsIn, decoded));
+		assert(decoded.str() == expected);
+	}
+
+	// Formats with separators in them survive the dictionary, corrupt input is rejected without reading past it
+	{
+		static const FormatSite site(LogLevel::Warning, "tab\t{}\\\nnext {}", "dir\tname.cpp", 1);
+		LogRecord record;
+		record.Site = &site;
+		EncodeArguments(record.Arguments, "text", 42);
+		std::string frame;
+		AppendRecord(record, true, frame);
+
+		std::stringstream dictionary;
+		WriteFormatDictionary(dictionary);
+		const std::string dictionaryText = dictionary.str();
+
+		[[maybe_unused]] auto decode = [](const std::string& DictionaryText, const std::string& Records, std::string& Text)
+			{
+				std::istringstream dictionaryIn(DictionaryText);
+				std::istringstream recordsIn(Records, std::ios::binary);
+				std::ostringstream decoded;
+				const bool valid = DecodeBinaryLog(dictionaryIn, recordsIn, decoded);
+				Text = decoded.str();
+				return valid;
+			};
+
+		std::string text;
+		assert(decode(dictionaryText, frame, text));
+		assert(text == "Logger :[WARNING] tab\ttext\\\nnext 42\n");
+
+		// The string length claims more bytes than the frame holds
+		std::string corrupt = frame;
+		const std::uint32_t hugeLength = 1000;
+		std::memcpy(&corrupt[2 * sizeof(std::uint32_t) + 1], &hugeLength, sizeof(hugeLength));
+		assert(!decode(dictionaryText, corrupt, text));
+
+		// The frame is shorter than its arguments: the size in the header is cut, the data is not
+		corrupt = frame;
+		const std::uint32_t shortSize = 3;
+		std::memcpy(&corrupt[sizeof(std::uint32_t)], &shortSize, sizeof(shortSize));
+		corrupt.resize(2 * sizeof(std::uint32_t) + shortSize);
+		assert(!decode(dictionaryText, corrupt, text));
+
+		// A size in the header far beyond the end of the stream is rejected without allocating it
+		corrupt = frame;
+		const std::uint32_t hugeSize = 0xFFFFFFF0u;
+		std::memcpy(&corrupt[sizeof(std::uint32_t)], &hugeSize, sizeof(hugeSize));
+		assert(!decode(dictionaryText, corrupt, text));
+
+		// Truncated frame, unknown argument type, malformed dictionary lines
+		assert(!decode(dictionaryText, frame.substr(0, frame.size() - 1), text));
+		corrupt = frame;
+		corrupt[2 * sizeof(std::uint32_t)] = 100;
+		assert(!decode(dictionaryText, corrupt, text));
+		assert(!decode(dictionaryText + "x\t2\tfile:1\tformat\n", frame, text));
+		assert(!decode(dictionaryText + "99999999999\t2\tfile:1\tformat\n", frame, text));
+		assert(!decode(dictionaryText + "7\t2\tfile:1\n", frame, text));
+		assert(!decode(dictionaryText + "7\t2\tfile:1\tbad \\q escape\n", frame, text));
+	}
+
+	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+void TestMappedFileSink()
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "PatternsMappedFileSink";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+
+	FileSinkOptions options;
+	options.BasePath = (directory / "test").string();
+	options.SegmentBytes = 4096;
+
+	auto readSegments = [&directory]()
+		{
+			std::vector<std::filesystem::path> segments;
+			for (const auto& entry : std::filesystem::directory_iterator(directory))
+			{
+				segments.push_back(entry.path());
+			}
+			std::sort(segments.begin(), segments.end());
+
+			std::string text;
+			for (const std::filesystem::path& segment : segments)
+			{
+				assert(std::filesystem::file_size(segment) <= 4096);
+				std::ifstream in(segment, std::ios::binary);
+				text.append(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+			}
+			return std::make_pair(segments.size(), text);
+		};
+
+	Logger& logger = Logger::GetInstance();
+
+	// Rotation by size: no line is split and the segments are trimmed to what was written
+	{
+		std::string expected;
+		MappedFileSink* sink = new MappedFileSink(options);
+		logger.SetSink(std::unique_ptr<LogSink>(sink));
+		for (int i = 0; i < 500; ++i)
+		{
+			logger.Log("record " + std::to_string(i));
+			expected += "Logger :record " + std::to_string(i) + "\n";
+		}
+		sink->Sync();
+		logger.SetSink(std::unique_ptr<LogSink>(new ConsoleSink()));
+
+		const auto segments = readSegments();
+		assert(segments.first > 1);
+		assert(segments.second == expected);
+	}
+
+	// Rotation by age, numbering continues after the existing segments
+	{
+		std::filesystem::remove_all(directory);
+		std::filesystem::create_directories(directory);
+		std::ofstream(options.BasePath + ".000000.log") << "Logger :earlier run\n";
+
+		options.MaxSegmentAge = std::chrono::milliseconds(1);
+		MappedFileSink* sink = new MappedFileSink(options);
+		logger.SetSink(std::unique_ptr<LogSink>(sink));
+		assert(sink->GetSegmentPath() == options.BasePath + ".000001.log");
+
+		logger.Log("first");
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		logger.Log("second");
+		assert(sink->GetSegmentPath() == options.BasePath + ".000002.log");
+		logger.SetSink(std::unique_ptr<LogSink>(new ConsoleSink()));
+
+		const auto segments = readSegments();
+		assert(segments.first == 3);
+		assert(segments.second == "Logger :earlier run\nLogger :first\nLogger :second\n");
+	}
+
+	// Retention cleanup deleted the oldest segment: the newer ones survive and numbering continues after them
+	{
+		std::filesystem::remove(options.BasePath + ".000000.log");
+		std::ofstream(options.BasePath + ".other.log") << "not a segment\n";
+
+		options.MaxSegmentAge = std::chrono::hours(1);
+		MappedFileSink* sink = new MappedFileSink(options);
+		logger.SetSink(std::unique_ptr<LogSink>(sink));
+		assert(sink->GetSegmentPath() == options.BasePath + ".000003.log");
+		logger.Log("third");
+		logger.SetSink(std::unique_ptr<LogSink>(new ConsoleSink()));
+
+		std::filesystem::remove(options.BasePath + ".other.log");
+		const auto segments = readSegments();
+		assert(segments.first == 3);
+		assert(segments.second == "Logger :first\nLogger :second\nLogger :third\n");
+	}
+
+	std::filesystem::remove_all(directory);
+
+	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+// Records the order in which the test singletons are created and destroyed
+std::vector<std::string>& SingletonEvents()
+{
+	static std::vector<std::string> Events;
+	return Events;
+}
+
+struct FirstService
+{
+	FirstService() { SingletonEvents().push_back("+First"); }
+	~FirstService() { SingletonEvents().push_back("-First"); }
+};
+
+// Uses FirstService while being created, so it has to be destroyed before it
+struct SecondService
+{
+	SecondService() { Singleton<FirstService>::Get(); SingletonEvents().push_back("+Second"); }
+	~SecondService() { SingletonEvents().push_back("-Second"); }
+};
+
+void TestGenericSingleton()
+{
+	SingletonEvents().clear();
+
+	// Created exactly once, however many threads race for it
+	std::vector<std::thread> threads;
+	std::vector<SecondService*> seen(8);
+	for (std::size_t t = 0; t < seen.size(); ++t)
+	{
+		threads.emplace_back([&seen, t]() { seen[t] = &Singleton<SecondService>::Get(); });
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	assert(std::all_of(seen.begin(), seen.end(), [&seen](SecondService* Instance) { return Instance == seen[0]; }));
+	assert((SingletonEvents() == std::vector<std::string>{ "+First", "+Second" }));
+
+	// Newest first; the Logger goes too and comes back on its next use
+	SingletonRegistry::ShutdownAll();
+	assert((SingletonEvents() == std::vector<std::string>{ "+First", "+Second", "-Second", "-First" }));
+	assert(!Singleton<FirstService>::IsAlive() && !Singleton<Logger>::IsAlive());
+
+	Singleton<FirstService>::Get();
+	Singleton<FirstService>::Destroy();
+	assert(SingletonEvents().size() == 6);
+	assert(&Logger::GetInstance() == &Singleton<Logger>::Get());
+
+	// A singleton destroyed early and created again counts as the newest, and leaves no stale entry behind
+	SingletonRegistry::ShutdownAll();
+	SingletonEvents().clear();
+	Singleton<SecondService>::Get();
+	[[maybe_unused]] const std::size_t registered = SingletonRegistry::GetCount();
+	for (int i = 0; i < 3; ++i)
+	{
+		Singleton<FirstService>::Destroy();
+		Singleton<FirstService>::Get();
+	}
+	assert(SingletonRegistry::GetCount() == registered);
+	SingletonRegistry::ShutdownAll();
+	assert(SingletonRegistry::GetCount() == 0);
+	assert((SingletonEvents() == std::vector<std::string>{ "+First", "+Second", "-First", "+First", "-First", "+First",
+		"-First", "+First", "-First", "-Second" }));
+
+	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+// Per-call latency percentiles of Log, single producer
+void ReportLogLatency(const std::string& Name, Logger& InLogger, std::size_t Messages)
+{
+	std::vector<double> latencies;
+	latencies.reserve(Messages);
+
+	const std::string message = "benchmark message with a typical length of about sixty characters";
+	for (std::size_t i = 0; i < Messages; ++i)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		InLogger.Log(message);
+		const auto finish = std::chrono::steady_clock::now();
+		latencies.push_back(std::chrono::duration<double, std::nano>(finish - start).count());
+	}
+	InLogger.Flush();
+
+	std::sort(latencies.begin(), latencies.end());
+	std::cout << Name << " latency ns p50: " << latencies[latencies.size() / 2]
+		<< " p99: " << latencies[latencies.size() * 99 / 100]
+		<< " max: " << latencies.back() << std::endl;
+}
+
+// Sync logging against the async backend, all written to a NullSink so only the logger is measured.
+// The async throughput includes the final Flush, i.e. everything has reached the sink.
+void BenchmarkLogger()
+{
+	const std::size_t Iterations = 200000;
+	const std::string message = "benchmark message with a typical length of about sixty characters";
+
+	Logger& logger = Logger::GetInstance();
+	logger.SetSink(std::unique_ptr<LogSink>(new NullSink()));
+
+	enum class Backend
+	{
+		Sync,
+		Async,
+		Buffered
+	};
+
+	struct Mode
+	{
+		const char* Name;
+		Backend Writer;
+		OverflowPolicy Overflow;
+	};
+	const Mode modes[] = {
+		{ "Logger sync", Backend::Sync, OverflowPolicy::Block },
+		{ "Logger async Block", Backend::Async, OverflowPolicy::Block },
+		{ "Logger async Drop", Backend::Async, OverflowPolicy::Drop },
+		{ "Logger async DropOldest", Backend::Async, OverflowPolicy::DropOldest },
+		{ "Logger buffered", Backend::Buffered, OverflowPolicy::Block },
+	};
+
+	for (const Mode& mode : modes)
+	{
+		if (mode.Writer == Backend::Async)
+		{
+			AsyncOptions options;
+			options.Overflow = mode.Overflow;
+			logger.StartAsync(options);
+		}
+		else if (mode.Writer == Backend::Buffered)
+		{
+			logger.StartBuffered();
+		}
+
+		for (int threads : Benchmark::ThreadCounts())
+		{
+			Benchmark::RunParallel(mode.Name, threads, Iterations, [&logger, &message](int, std::size_t Count)
+				{
+					for (std::size_t i = 0; i < Count; ++i)
+					{
+						logger.Log(message);
+					}
+					logger.Flush();
+				});
+		}
+
+		ReportLogLatency(mode.Name, logger, Iterations);
+		logger.StopAsync();
+	}
+
+	logger.SetSink(std::unique_ptr<LogSink>(new ConsoleSink()));
+}
+
+// Building the message on the caller against capturing the arguments, and a level that is compiled out.
+// Async mode, so the formatting cost of LOGGER_INFO moves to the background thread; the run includes the final Flush.
+void BenchmarkFormattedLogging()
+{
+	const std::size_t Iterations = 500000;
+
+	Logger& logger = Logger::GetInstance();
+	logger.SetSink(std::unique_ptr<LogSink>(new NullSink()));
+	logger.StartAsync();
+
+	Benchmark::Run("Logger Log(std::string built by caller)", Iterations, [&logger](std::size_t Count)
+		{
+			for (std::size_t i = 0; i < Count; ++i)
+			{
+				logger.Log("request " + std::to_string(i) + " took " + std::to_string(i % 1000 * 0.25) + " ms");
+			}
+			logger.Flush();
+		});
+
+	Benchmark::Run("Logger LOGGER_INFO(format, args)", Iterations, [&logger](std::size_t Count)
+		{
+			for (std::size_t i = 0; i < Count; ++i)
+			{
+				LOGGER_INFO("request {} took {} ms", i, i % 1000 * 0.25);
+			}
+			logger.Flush();
+		});
+
+	Benchmark::Run("Logger LOGGER_DEBUG(format, args) compiled out", Iterations, [](std::size_t Count)
+		{
+			for (std::size_t i = 0; i < Count; ++i)
+			{
+				LOGGER_DEBUG("request {} took {} ms", i, i % 1000 * 0.25);
+				Benchmark::DoNotOptimize(i);
+			}
+		});
+
+	logger.StopAsync();
+	logger.SetSink(std::unique_ptr<LogSink>(new ConsoleSink()));
+}
+
+// Synchronous logging, which flushes after every record, to a mapped segment file, an ofstream and the console.
+// std::cout is pointed at the null device for the console run: what is measured is the cout path and one write
+// per record, not the terminal. Then the same files written through the buffered mode's batches.
+void BenchmarkFileSinks()
+{
+	const std::size_t Iterations = 200000;
+	const std::string message = "benchmark message with a typical length of about sixty characters";
+
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "PatternsFileSinkBenchmark";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+
+	FileSinkOptions options;
+	options.BasePath = (directory / "mapped").string();
+	options.SegmentBytes = 64 * 1024 * 1024;
+
+	Logger& logger = Logger::GetInstance();
+	auto logMessages = [&logger, &message](std::size_t Count)
+		{
+			for (std::size_t i = 0; i < Count; ++i)
+			{
+				logger.Log(message);
+			}
+			logger.Flush();
+		};
+
+	for (bool buffered : { false, true })
+	{
+		const std::string mode = buffered ? " buffered" : " sync";
+
+		logger.SetSink(std::unique_ptr<LogSink>(new MappedFileSink(options)));
+		if (buffered)
+		{
+			logger.StartBuffered();
+		}
+		Benchmark::Run("Logger MappedFileSink" + mode, Iterations, logMessages);
+		logger.StopAsync();
+
+		std::ofstream file(directory / "stream.log", std::ios::binary | std::ios::trunc);
+		logger.SetSink(std::unique_ptr<LogSink>(new StreamSink(file)));
+		if (buffered)
+		{
+			logger.StartBuffered();
+		}
+		Benchmark::Run("Logger StreamSink(std::ofstream)" + mode, Iterations, logMessages);
+		logger.StopAsync();
+		logger.SetSink(std::unique_ptr<LogSink>(new NullSink()));
+	}
+
+#ifdef _WIN32
+	std::ofstream nullDevice("NUL");
+#else
+	std::ofstream nullDevice("/dev/null");
+#endif
+	std::streambuf* console = std::cout.rdbuf(nullDevice.rdbuf());
+	logger.SetSink(std::unique_ptr<LogSink>(new ConsoleSink()));
+	const Benchmark::Result consoleResult = Benchmark::Run("Logger ConsoleSink sync", Iterations, logMessages);
+	std::cout.rdbuf(console);
+	Benchmark::Report(consoleResult);
+	Benchmark::Results().pop_back();
+
+	std::filesystem::remove_all(directory);
+}
+
+struct AccessedService
+{
+	int Value = 1;
+};
+
+// The accessor Logger used to have
+struct CallOnceAccessor
+{
+	static AccessedService& Get()
+	{
+		std::call_once(Flag, []() { Instance.reset(new AccessedService()); });
+		return *Instance;
+	}
+
+	static inline std::once_flag Flag;
+	static inline std::unique_ptr<AccessedService> Instance;
+};
+
+struct LocalStaticAccessor
+{
+	static AccessedService& Get()
+	{
+		static AccessedService Instance;
+		return Instance;
+	}
+};
+
+// What GetInstance costs per call from many threads at once: the Singleton<T> fast path, a function-local
+// static and std::call_once + std::unique_ptr
+void BenchmarkSingletonAccess()
+{
+	const std::size_t Iterations = 10000000;
+
+	auto measure = [Iterations](const std::string& Name, auto Get)
+		{
+			for (int threads : Benchmark::ThreadCounts())
+			{
+				Benchmark::RunParallel(Name, threads, Iterations, [Get](int, std::size_t Count)
+					{
+						int sum = 0;
+						for (std::size_t i = 0; i < Count; ++i)
+						{
+							AccessedService& instance = Get();
+							Benchmark::DoNotOptimize(instance);
+							sum += instance.Value;
+						}
+						Benchmark::DoNotOptimize(sum);
+					});
+			}
+		};
+
+	measure("Singleton<T>::Get", []() -> AccessedService& { return Singleton<AccessedService>::Get(); });
+	measure("function-local static", []() -> AccessedService& { return LocalStaticAccessor::Get(); });
+	measure("std::call_once + std::unique_ptr", []() -> AccessedService& { return CallOnceAccessor::Get(); });
+}
+
+} // namespace Singleton
\ No newline at end of file
@@ -0,0 +1,33 @@
+﻿// LogDecoder.cpp : Offline decoder for logs written by Singleton::BinaryStreamSink.
+// Usage: PatternsLogDecoder <dictionary> <records>
+// The dictionary is the output of Singleton::WriteFormatDictionary from the run that wrote the records.
+
+#include <fstream>
+#include <iostream>
+
+#include "Creational/Singleton.h"
+
+int main(int argc, char* argv[])
+{
+	if (argc != 3)
+	{
+		std::cerr << "Usage: " << argv[0] << " <dictionary> <records>" << std::endl;
+		return 1;
+	}
+
+	std::ifstream dictionary(argv[1]);
+	std::ifstream records(argv[2], std::ios::binary);
+	if (!dictionary || !records)
+	{
+		std::cerr << "Cannot open " << (!dictionary ? argv[1] : argv[2]) << std::endl;
+		return 1;
+	}
+
+	if (!Singleton::DecodeBinaryLog(dictionary, records, std::cout))
+	{
+		std::cerr << "Records do not match the dictionary or are truncated" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -49,18 +49,33 @@ int main()
 
 	std::cout << "\n=== Factory Method Pattern ===\n";
 	FactoryMethod::TestFactoryMethod();
+	FactoryMethod::TestPooledVehicleFactory();
+	FactoryMethod::TestStaticVehicleFactory();
+	FactoryMethod::TestVehicleBatches();
+	FactoryMethod::TestVehicleNameRegistry();
 
 	std::cout << "\n=== Abstract Factory Pattern ===\n";
 	AbstractFactory::TestAbstractFactory();
+	AbstractFactory::TestWidgetFactories();
+	AbstractFactory::TestDrawList();
+	AbstractFactory::TestStaticGUIFactory();
 
 	std::cout << "\n=== Builder Pattern ===\n";
 	Builder::TestBuilderPattern();
+	Builder::TestPCValueBuilder();
+	Builder::TestBuildMany();
+	Builder::TestPCSpec();
 
 	std::cout << "\n=== Prototype Pattern ===\n";
 	Prototype::TestPrototypePattern();
 
 	std::cout << "\n=== Singleton Pattern ===\n";
 	Singleton::TestSingletonPattern();
+	Singleton::TestAsyncLogger();
+	Singleton::TestBufferedLogger();
+	Singleton::TestFormattedLogger();
+	Singleton::TestMappedFileSink();
+	Singleton::TestGenericSingleton();
 
 
 	//std::cout << "\n=== Adapter Pattern ===\n";
@@ -117,6 +132,7 @@ int main()
 
 	//std::cout << "\n=== Custom Smart Pointers ===\n";
 	//SmartPointers::TestSmartPointers();
+	//SmartPointers::BenchmarkSmartPointers();
 
 	return 0;
 }
@@ -1,57 +1,603 @@
 ﻿// Custom smart pointers implementation
 
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include "../Benchmark.h"
 
 namespace SmartPointers
 {
+// Reference counting policies.
+// SingleThreadPolicy keeps plain integer counters and is the zero-overhead default,
+// MultiThreadPolicy makes the control block safe to share between threads.
+struct SingleThreadPolicy
+{
+	using CounterType = int;
+
+	static void Increment(CounterType& Counter) { ++Counter; }
+
+	// Returns true when the counter dropped to zero
+	static bool Decrement(CounterType& Counter) { return --Counter == 0; }
+
+	static bool IncrementIfNotZero(CounterType& Counter)
+	{
+		if (Counter == 0)
+		{
+			return false;
+		}
+		++Counter;
+		return true;
+	}
+
+	static int Load(const CounterType& Counter) { return Counter; }
+};
+
+struct MultiThreadPolicy
+{
+	using CounterType = std::atomic<int>;
+
+	// A new reference is always made from an existing one, so nothing has to be ordered here
+	static void Increment(CounterType& Counter) { Counter.fetch_add(1, std::memory_order_relaxed); }
+
+	// Release publishes our writes to the object, acquire makes all of them visible to the thread that destroys it
+	static bool Decrement(CounterType& Counter) { return Counter.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+
+	static bool IncrementIfNotZero(CounterType& Counter)
+	{
+		int Expected = Counter.load(std::memory_order_relaxed);
+		while (Expected != 0)
+		{
+			if (Counter.compare_exchange_weak(Expected, Expected + 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static int Load(const CounterType& Counter) { return Counter.load(std::memory_order_acquire); }
+};
+
+// Opt-in statistics: build with SMART_POINTERS_STATISTICS=1 (CMake option PATTERNS_SMART_POINTER_STATISTICS)
+// to count control block allocations, copies, moves, weak locks and object lifetimes per type.
+// When disabled the hooks compile to nothing and ControlStruct carries no extra members.
+#ifndef SMART_POINTERS_STATISTICS
+#define SMART_POINTERS_STATISTICS 0
+#endif
+
+namespace Statistics
+{
+constexpr bool Enabled = SMART_POINTERS_STATISTICS != 0;
+
+using Clock = std::chrono::steady_clock;
+
+struct TypeCounters
+{
+	explicit TypeCounters(const char* InTypeName);
+
+	const char* TypeName;
+	std::atomic<std::uint64_t> Allocations;
+	std::atomic<std::uint64_t> Copies;
+	std::atomic<std::uint64_t> Moves;
+	std::atomic<std::uint64_t> WeakLocks;
+	std::atomic<std::uint64_t> FailedWeakLocks;
+	std::atomic<std::uint64_t> Destructions;
+	std::atomic<std::int64_t> Live;
+	std::atomic<std::int64_t> PeakLive;
+	std::atomic<std::uint64_t> TotalLifetimeNanoseconds;
+	std::atomic<std::uint64_t> MaxLifetimeNanoseconds;
+
+	// Every TypeCounters is linked into a global list on first use, see Registry()
+	TypeCounters* Next;
+};
+
+// Plain copy of TypeCounters for reporting
+struct TypeSnapshot
+{
+	std::string TypeName;
+	std::uint64_t Allocations;
+	std::uint64_t Copies;
+	std::uint64_t Moves;
+	std::uint64_t WeakLocks;
+	std::uint64_t FailedWeakLocks;
+	std::uint64_t Destructions;
+	std::int64_t Live;
+	std::int64_t PeakLive;
+	std::uint64_t TotalLifetimeNanoseconds;
+	std::uint64_t MaxLifetimeNanoseconds;
+};
+
+// Head of the list of all TypeCounters; registration is a lock-free push
+inline std::atomic<TypeCounters*>& Registry()
+{
+	static std::atomic<TypeCounters*> Head(nullptr);
+	return Head;
+}
+
+inline TypeCounters::TypeCounters(const char* InTypeName)
+	: TypeName(InTypeName)
+	, Allocations(0)
+	, Copies(0)
+	, Moves(0)
+	, WeakLocks(0)
+	, FailedWeakLocks(0)
+	, Destructions(0)
+	, Live(0)
+	, PeakLive(0)
+	, TotalLifetimeNanoseconds(0)
+	, MaxLifetimeNanoseconds(0)
+	, Next(Registry().load(std::memory_order_relaxed))
+{
+	while (!Registry().compare_exchange_weak(Next, this, std::memory_order_release, std::memory_order_relaxed))
+	{
+	}
+}
+
+template<typename T>
+TypeCounters& CountersFor()
+{
+	static TypeCounters Counters(typeid(T).name());
+	return Counters;
+}
+
+template<typename CounterType>
+void StoreMax(std::atomic<CounterType>& Target, CounterType Value)
+{
+	CounterType Current = Target.load(std::memory_order_relaxed);
+	while (Current < Value && !Target.compare_exchange_weak(Current, Value, std::memory_order_relaxed))
+	{
+	}
+}
+
+// Remembers in the control block who to report the object's destruction to
+template<typename T, typename ControlBlockType>
+void RecordAllocation(ControlBlockType& Block)
+{
+	if constexpr (Enabled)
+	{
+		TypeCounters& Counters = CountersFor<T>();
+		Counters.Allocations.fetch_add(1, std::memory_order_relaxed);
+		StoreMax(Counters.PeakLive, Counters.Live.fetch_add(1, std::memory_order_relaxed) + 1);
+
+		Block.Counters = &Counters;
+		Block.CreationTime = Clock::now();
+	}
+}
+
+inline void RecordDestruction(TypeCounters* Counters, Clock::time_point CreationTime)
+{
+	if constexpr (Enabled)
+	{
+		const auto Lifetime = static_cast<std::uint64_t>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - CreationTime).count());
+
+		Counters->Destructions.fetch_add(1, std::memory_order_relaxed);
+		Counters->Live.fetch_sub(1, std::memory_order_relaxed);
+		Counters->TotalLifetimeNanoseconds.fetch_add(Lifetime, std::memory_order_relaxed);
+		StoreMax(Counters->MaxLifetimeNanoseconds, Lifetime);
+	}
+}
+
+template<typename T>
+void RecordCopy()
+{
+	if constexpr (Enabled)
+	{
+		CountersFor<T>().Copies.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+template<typename T>
+void RecordMove()
+{
+	if constexpr (Enabled)
+	{
+		CountersFor<T>().Moves.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+template<typename T>
+void RecordWeakLock(bool Succeeded)
+{
+	if constexpr (Enabled)
+	{
+		TypeCounters& Counters = CountersFor<T>();
+		Counters.WeakLocks.fetch_add(1, std::memory_order_relaxed);
+		if (!Succeeded)
+		{
+			Counters.FailedWeakLocks.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+}
+
+inline std::vector<TypeSnapshot> TakeSnapshot()
+{
+	std::vector<TypeSnapshot> Snapshots;
+	for (TypeCounters* Counters = Registry().load(std::memory_order_acquire); Counters != nullptr; Counters = Counters->Next)
+	{
+		Snapshots.push_back(TypeSnapshot{
+			Counters->TypeName,
+			Counters->Allocations.load(std::memory_order_relaxed),
+			Counters->Copies.load(std::memory_order_relaxed),
+			Counters->Moves.load(std::memory_order_relaxed),
+			Counters->WeakLocks.load(std::memory_order_relaxed),
+			Counters->FailedWeakLocks.load(std::memory_order_relaxed),
+			Counters->Destructions.load(std::memory_order_relaxed),
+			Counters->Live.load(std::memory_order_relaxed),
+			Counters->PeakLive.load(std::memory_order_relaxed),
+			Counters->TotalLifetimeNanoseconds.load(std::memory_order_relaxed),
+			Counters->MaxLifetimeNanoseconds.load(std::memory_order_relaxed)});
+	}
+	return Snapshots;
+}
+
+// Starts counting from zero again; live objects stay live
+inline void Reset()
+{
+	for (TypeCounters* Counters = Registry().load(std::memory_order_acquire); Counters != nullptr; Counters = Counters->Next)
+	{
+		Counters->Allocations = 0;
+		Counters->Copies = 0;
+		Counters->Moves = 0;
+		Counters->WeakLocks = 0;
+		Counters->FailedWeakLocks = 0;
+		Counters->Destructions = 0;
+		Counters->PeakLive = Counters->Live.load();
+		Counters->TotalLifetimeNanoseconds = 0;
+		Counters->MaxLifetimeNanoseconds = 0;
+	}
+}
+
+// Prometheus text exposition format, one sample per line, e.g.
+// smart_pointers_copies_total{type="i"} 12
+inline void Dump(std::ostream& Out)
+{
+	for (const TypeSnapshot& Snapshot : TakeSnapshot())
+	{
+		const std::string Label = "{type=\"" + Snapshot.TypeName + "\"} ";
+		Out << "smart_pointers_allocations_total" << Label << Snapshot.Allocations << "\n";
+		Out << "smart_pointers_copies_total" << Label << Snapshot.Copies << "\n";
+		Out << "smart_pointers_moves_total" << Label << Snapshot.Moves << "\n";
+		Out << "smart_pointers_weak_locks_total" << Label << Snapshot.WeakLocks << "\n";
+		Out << "smart_pointers_failed_weak_locks_total" << Label << Snapshot.FailedWeakLocks << "\n";
+		Out << "smart_pointers_destructions_total" << Label << Snapshot.Destructions << "\n";
+		Out << "smart_pointers_live" << Label << Snapshot.Live << "\n";
+		Out << "smart_pointers_peak_live" << Label << Snapshot.PeakLive << "\n";
+		Out << "smart_pointers_lifetime_nanoseconds_total" << Label << Snapshot.TotalLifetimeNanoseconds << "\n";
+		Out << "smart_pointers_lifetime_nanoseconds_max" << Label << Snapshot.MaxLifetimeNanoseconds << "\n";
+	}
+}
+} // namespace Statistics
+
+template<typename ThreadPolicy = SingleThreadPolicy>
 struct ControlStruct
 {
-	int SharedCounter;
-	int WeakCounter;
+	typename ThreadPolicy::CounterType SharedCounter;
+	// All shared owners together hold one weak reference, so the block outlives the last SharedPointer
+	// for as long as WeakPointers still look at it
+	typename ThreadPolicy::CounterType WeakCounter;
+
+#if SMART_POINTERS_STATISTICS
+	Statistics::TypeCounters* Counters = nullptr;
+	Statistics::Clock::time_point CreationTime;
+#endif
 
 	ControlStruct() : SharedCounter(1), WeakCounter(1) {}
+	virtual ~ControlStruct() = default;
+
+	void ReleaseShared()
+	{
+		if (ThreadPolicy::Decrement(SharedCounter))
+		{
+#if SMART_POINTERS_STATISTICS
+			if (Counters != nullptr)
+			{
+				Statistics::RecordDestruction(Counters, CreationTime);
+			}
+#endif
+			DestroyObject();
+			ReleaseWeak();
+		}
+	}
+
+	void ReleaseWeak()
+	{
+		if (ThreadPolicy::Decrement(WeakCounter))
+		{
+			DestroySelf();
+		}
+	}
+
+protected:
+	// Called once the last SharedPointer is gone
+	virtual void DestroyObject() = 0;
+	// Called once the last WeakPointer is gone as well
+	virtual void DestroySelf() = 0;
 };
 
 template<typename T>
+struct DefaultDelete
+{
+	void operator()(T* InPointer) const { delete InPointer; }
+};
+
+template<typename T>
+struct DefaultDelete<T[]>
+{
+	void operator()(T* InPointer) const { delete[] InPointer; }
+};
+
+// Holds a deleter or an allocator. Empty ones are stored as a base class so they take no space.
+// Index only tells apart two storages of the same type in one class.
+template<typename T, int Index = 0, bool IsEmpty = std::is_empty<T>::value && !std::is_final<T>::value>
+class EmptyBaseStorage : private T
+{
+public:
+	EmptyBaseStorage() = default;
+	explicit EmptyBaseStorage(T InValue) : T(std::move(InValue)) {}
+
+	T& Get() { return *this; }
+	const T& Get() const { return *this; }
+};
+
+template<typename T, int Index>
+class EmptyBaseStorage<T, Index, false>
+{
+public:
+	EmptyBaseStorage() = default;
+	explicit EmptyBaseStorage(T InValue) : Value(std::move(InValue)) {}
+
+	T& Get() { return Value; }
+	const T& Get() const { return Value; }
+
+private:
+	T Value;
+};
+
+// Control blocks get their memory from the allocator they were created with
+template<typename BlockType, typename Allocator, typename... ArgTypes>
+BlockType* CreateControlBlock(const Allocator& InAllocator, ArgTypes&&... Args)
+{
+	using BlockAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<BlockType>;
+	using BlockTraits = std::allocator_traits<BlockAllocator>;
+
+	BlockAllocator Alloc(InAllocator);
+	BlockType* Block = BlockTraits::allocate(Alloc, 1);
+	try
+	{
+		::new (static_cast<void*>(Block)) BlockType(std::forward<ArgTypes>(Args)...);
+	}
+	catch (...)
+	{
+		BlockTraits::deallocate(Alloc, Block, 1);
+		throw;
+	}
+	return Block;
+}
+
+template<typename BlockType, typename Allocator>
+void DestroyControlBlock(BlockType* Block, const Allocator& InAllocator)
+{
+	using BlockAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<BlockType>;
+
+	BlockAllocator Alloc(InAllocator);
+	Block->~BlockType();
+	std::allocator_traits<BlockAllocator>::deallocate(Alloc, Block, 1);
+}
+
+// Control block for an object allocated separately, e.g. SharedPointer<T>(new T).
+// The deleter is type-erased here, so SharedPointers with different deleters have the same type.
+template<typename T, typename Deleter, typename Allocator, typename ThreadPolicy>
+struct PointerControlStruct
+	: public ControlStruct<ThreadPolicy>
+	, private EmptyBaseStorage<Deleter, 0>
+	, private EmptyBaseStorage<Allocator, 1>
+{
+	PointerControlStruct(T* InObject, Deleter InDeleter, const Allocator& InAllocator)
+		: EmptyBaseStorage<Deleter, 0>(std::move(InDeleter))
+		, EmptyBaseStorage<Allocator, 1>(InAllocator)
+		, Object(InObject)
+	{}
+
+protected:
+	void DestroyObject() override { EmptyBaseStorage<Deleter, 0>::Get()(Object); }
+
+	void DestroySelf() override
+	{
+		// The allocator is a part of this block, keep a copy while it is being freed
+		Allocator Alloc(EmptyBaseStorage<Allocator, 1>::Get());
+		DestroyControlBlock(this, Alloc);
+	}
+
+private:
+	T* Object;
+};
+
+// Control block with the object stored right after the counters, used by MakeShared and AllocateShared.
+// The object is destroyed with the last SharedPointer, the memory is freed with the last WeakPointer.
+template<typename T, typename Allocator, typename ThreadPolicy>
+struct InPlaceControlStruct
+	: public ControlStruct<ThreadPolicy>
+	, private EmptyBaseStorage<Allocator>
+{
+	template<typename... ArgTypes>
+	explicit InPlaceControlStruct(const Allocator& InAllocator, ArgTypes&&... Args)
+		: EmptyBaseStorage<Allocator>(InAllocator)
+	{
+		::new (static_cast<void*>(Storage)) T(std::forward<ArgTypes>(Args)...);
+	}
+
+	T* GetObject() { return std::launder(reinterpret_cast<T*>(Storage)); }
+
+protected:
+	void DestroyObject() override { GetObject()->~T(); }
+
+	void DestroySelf() override
+	{
+		Allocator Alloc(EmptyBaseStorage<Allocator>::Get());
+		DestroyControlBlock(this, Alloc);
+	}
+
+private:
+	alignas(T) unsigned char Storage[sizeof(T)];
+};
+
+template<typename T, typename ThreadPolicy = SingleThreadPolicy>
 class WeakPointer;
 
+template<typename T, typename ThreadPolicy = SingleThreadPolicy>
+class SharedPointer;
+
 template<typename T>
+class AtomicSharedPointer;
+
+template<typename T, typename Deleter = DefaultDelete<T>>
+class UniquePointer;
+
+template<typename T, typename ThreadPolicy = SingleThreadPolicy, typename... ArgTypes>
+SharedPointer<T, ThreadPolicy> MakeShared(ArgTypes&&... Args);
+
+template<typename T, typename ThreadPolicy = SingleThreadPolicy, typename Allocator, typename... ArgTypes>
+SharedPointer<T, ThreadPolicy> AllocateShared(const Allocator& InAllocator, ArgTypes&&... Args);
+
+template<typename T, typename ThreadPolicy = SingleThreadPolicy>
+class EnableSharedFromThis;
+
+// Called whenever a new control block takes ownership of an object, remembers it in EnableSharedFromThis
+template<typename U, typename ObjectPolicy, typename ThreadPolicy>
+void AttachSharedFromThis(const EnableSharedFromThis<U, ObjectPolicy>* Object, ControlStruct<ThreadPolicy>* InControlBlock)
+{
+	static_assert(std::is_same<ObjectPolicy, ThreadPolicy>::value,
+		"EnableSharedFromThis must use the same ThreadPolicy as the SharedPointer that owns the object");
+
+	if (Object != nullptr && Object->OwnerControlBlock == nullptr)
+	{
+		Object->OwnerControlBlock = InControlBlock;
+	}
+}
+
+inline void AttachSharedFromThis(...) {}
+
+template<typename T, typename ThreadPolicy>
 class SharedPointer
 {
 public:
-	explicit SharedPointer(T* InPointer = nullptr)
-		: Pointer(InPointer)
-		, ControlBlock(InPointer != nullptr ? new ControlStruct() : nullptr)
+	// SharedPointer<T[]> manages an array: it owns ElementType* and releases it with delete[]
+	using ElementType = std::remove_extent_t<T>;
+
+	explicit SharedPointer(ElementType* InPointer = nullptr)
+		: SharedPointer(InPointer, DefaultDelete<T>())
 	{}
 
-	SharedPointer(const SharedPointer<T>& other)
+	template<typename Deleter>
+	SharedPointer(ElementType* InPointer, Deleter InDeleter)
+		: SharedPointer(InPointer, std::move(InDeleter), std::allocator<std::remove_cv_t<ElementType>>())
+	{}
+
+	// The control block is allocated with InAllocator, the object is released with InDeleter
+	template<typename Deleter, typename Allocator>
+	SharedPointer(ElementType* InPointer, Deleter InDeleter, const Allocator& InAllocator)
+		: Pointer(nullptr)
+		, ControlBlock(nullptr)
+	{
+		if (InPointer != nullptr)
+		{
+			// Releases the object if the control block cannot be allocated
+			UniquePointer<ElementType, Deleter> Guard(InPointer, InDeleter);
+			ControlBlock = CreateControlBlock<PointerControlStruct<ElementType, Deleter, Allocator, ThreadPolicy>>(
+				InAllocator, InPointer, InDeleter, InAllocator);
+			Pointer = Guard.Release();
+			Statistics::RecordAllocation<T>(*ControlBlock);
+
+			if constexpr (!std::is_array<T>::value)
+			{
+				AttachSharedFromThis(Pointer, ControlBlock);
+			}
+		}
+	}
+
+	SharedPointer(const SharedPointer<T, ThreadPolicy>& other)
 		: Pointer(other.Pointer)
 		, ControlBlock(other.ControlBlock)
 	{
 		if (ControlBlock != nullptr)
 		{
-			ControlBlock->SharedCounter++;
+			ThreadPolicy::Increment(ControlBlock->SharedCounter);
+			Statistics::RecordCopy<T>();
 		}
 	}
 
-	SharedPointer(SharedPointer<T>&& other) noexcept
+	SharedPointer(SharedPointer<T, ThreadPolicy>&& other) noexcept
 		: Pointer(other.Pointer)
 		, ControlBlock(other.ControlBlock)
 	{
 		other.Pointer = nullptr;
 		other.ControlBlock = nullptr;
+		Statistics::RecordMove<T>();
 	}
 
-	SharedPointer(const WeakPointer<T> other)
-		: Pointer(other.Pointer)
-		, ControlBlock(other.ControlBlock)
+	// Converting constructors, e.g. from SharedPointer<Derived> to SharedPointer<Base>.
+	// The control block still destroys the object through the type it was created with.
+	template<typename U, typename = std::enable_if_t<std::is_convertible<typename SharedPointer<U, ThreadPolicy>::ElementType*, ElementType*>::value>>
+	SharedPointer(const SharedPointer<U, ThreadPolicy>& other)
+		: SharedPointer(other, other.Get())
+	{}
+
+	template<typename U, typename = std::enable_if_t<std::is_convertible<typename SharedPointer<U, ThreadPolicy>::ElementType*, ElementType*>::value>>
+	SharedPointer(SharedPointer<U, ThreadPolicy>&& other) noexcept
+		: SharedPointer(std::move(other), other.Get())
+	{}
+
+	// Aliasing constructors: share the ownership of Owner but point to InPointer, e.g. to a member of the owned object
+	template<typename U>
+	SharedPointer(const SharedPointer<U, ThreadPolicy>& Owner, ElementType* InPointer)
+		: Pointer(InPointer)
+		, ControlBlock(Owner.ControlBlock)
 	{
 		if (ControlBlock != nullptr)
 		{
-			ControlBlock->SharedCounter++;
+			ThreadPolicy::Increment(ControlBlock->SharedCounter);
+			Statistics::RecordCopy<T>();
+		}
+	}
+
+	template<typename U>
+	SharedPointer(SharedPointer<U, ThreadPolicy>&& Owner, ElementType* InPointer) noexcept
+		: Pointer(InPointer)
+		, ControlBlock(Owner.ControlBlock)
+	{
+		Owner.Pointer = nullptr;
+		Owner.ControlBlock = nullptr;
+		Statistics::RecordMove<T>();
+	}
+
+	// Stays empty if the object is already gone
+	SharedPointer(const WeakPointer<T, ThreadPolicy>& other)
+		: Pointer(nullptr)
+		, ControlBlock(nullptr)
+	{
+		if (other.ControlBlock != nullptr && ThreadPolicy::IncrementIfNotZero(other.ControlBlock->SharedCounter))
+		{
+			Pointer = other.Pointer;
+			ControlBlock = other.ControlBlock;
 		}
+		Statistics::RecordWeakLock<T>(ControlBlock != nullptr);
 	}
 
 	~SharedPointer()
@@ -59,7 +605,7 @@ public:
 		Release();
 	}
 
-	SharedPointer<T>& operator=(const SharedPointer<T>& other)
+	SharedPointer<T, ThreadPolicy>& operator=(const SharedPointer<T, ThreadPolicy>& other)
 	{
 		if (this != &other)
 		{
@@ -69,13 +615,14 @@ public:
 			ControlBlock = other.ControlBlock;
 			if (ControlBlock != nullptr)
 			{
-				ControlBlock->SharedCounter++;
+				ThreadPolicy::Increment(ControlBlock->SharedCounter);
+				Statistics::RecordCopy<T>();
 			}
 		}
 		return *this;
 	}
 
-	SharedPointer<T>& operator=(SharedPointer<T>&& other) noexcept
+	SharedPointer<T, ThreadPolicy>& operator=(SharedPointer<T, ThreadPolicy>&& other) noexcept
 	{
 		if (this != &other)
 		{
@@ -86,23 +633,30 @@ public:
 
 			other.Pointer = nullptr;
 			other.ControlBlock = nullptr;
+			Statistics::RecordMove<T>();
 		}
 		return *this;
 	}
 
-	T* operator->() const
+	ElementType* operator->() const
 	{
 		return Pointer;
 	}
 
-	T& operator*() const
+	ElementType& operator*() const
 	{
 		return *Pointer;
 	}
 
-	T* Get() const { return Pointer; }
+	ElementType& operator[](std::ptrdiff_t Index) const
+	{
+		static_assert(std::is_array<T>::value, "operator[] is only available for SharedPointer<T[]>");
+		return Pointer[Index];
+	}
 
-	int UseCount() const { return ControlBlock != nullptr ? ControlBlock->SharedCounter : 0; }
+	ElementType* Get() const { return Pointer; }
+
+	int UseCount() const { return ControlBlock != nullptr ? ThreadPolicy::Load(ControlBlock->SharedCounter) : 0; }
 
 
 
@@ -111,56 +665,83 @@ private:
 	{
 		if (ControlBlock != nullptr)
 		{
-			if (--ControlBlock->SharedCounter == 0)
-			{
-				delete Pointer;
-				Pointer = nullptr;
-				if (ControlBlock->WeakCounter == 0)
-				{
-					delete ControlBlock;
-					ControlBlock = nullptr;
-				}
-			}
+			ControlBlock->ReleaseShared();
+			Pointer = nullptr;
+			ControlBlock = nullptr;
 		}
 	}
 
+	struct AdoptReference {};
+
+	// Takes over a reference that is already accounted for in InControlBlock
+	SharedPointer(AdoptReference, ElementType* InPointer, ControlStruct<ThreadPolicy>* InControlBlock)
+		: Pointer(InPointer)
+		, ControlBlock(InControlBlock)
+	{}
+
 private:
-	T* Pointer;
-	ControlStruct* ControlBlock;
+	ElementType* Pointer;
+	ControlStruct<ThreadPolicy>* ControlBlock;
+
+	template<typename U, typename P>
+	friend class SharedPointer;
 
-	friend class WeakPointer<T>;
+	template<typename U, typename P>
+	friend class WeakPointer;
+
+	template<typename U>
+	friend class AtomicSharedPointer;
+
+	template<typename U, typename P>
+	friend class EnableSharedFromThis;
+
+	template<typename U, typename P, typename Allocator, typename... ArgTypes>
+	friend SharedPointer<U, P> AllocateShared(const Allocator& InAllocator, ArgTypes&&... Args);
 };
 
-template<typename T>
+template<typename T, typename ThreadPolicy>
 class WeakPointer
 {
 public:
+	using ElementType = std::remove_extent_t<T>;
+
 	WeakPointer()
 		: Pointer(nullptr)
 		, ControlBlock(nullptr)
 	{}
 
-	WeakPointer(const SharedPointer<T>& InSharedPointer)
+	WeakPointer(const SharedPointer<T, ThreadPolicy>& InSharedPointer)
+		: Pointer(InSharedPointer.Pointer)
+		, ControlBlock(InSharedPointer.ControlBlock)
+	{
+		if (ControlBlock != nullptr)
+		{
+			ThreadPolicy::Increment(ControlBlock->WeakCounter);
+		}
+	}
+
+	template<typename U, typename = std::enable_if_t<std::is_convertible<typename SharedPointer<U, ThreadPolicy>::ElementType*, ElementType*>::value>>
+	WeakPointer(const SharedPointer<U, ThreadPolicy>& InSharedPointer)
 		: Pointer(InSharedPointer.Pointer)
 		, ControlBlock(InSharedPointer.ControlBlock)
 	{
 		if (ControlBlock != nullptr)
 		{
-			ControlBlock->WeakCounter++;
+			ThreadPolicy::Increment(ControlBlock->WeakCounter);
 		}
 	}
 
-	WeakPointer(const WeakPointer<T>& other)
+	WeakPointer(const WeakPointer<T, ThreadPolicy>& other)
 		: Pointer(other.Pointer)
 		, ControlBlock(other.ControlBlock)
 	{
 		if (ControlBlock != nullptr)
 		{
-			ControlBlock->WeakCounter++;
+			ThreadPolicy::Increment(ControlBlock->WeakCounter);
 		}
 	}
 
-	WeakPointer(WeakPointer<T>&& other) noexcept
+	WeakPointer(WeakPointer<T, ThreadPolicy>&& other) noexcept
 		: Pointer(other.Pointer)
 		, ControlBlock(other.ControlBlock)
 	{
@@ -173,7 +754,7 @@ public:
 		Release();
 	}
 
-	WeakPointer<T>& operator=(const WeakPointer<T>& other)
+	WeakPointer<T, ThreadPolicy>& operator=(const WeakPointer<T, ThreadPolicy>& other)
 	{
 		if (this != &other)
 		{
@@ -183,13 +764,13 @@ public:
 			ControlBlock = other.ControlBlock;
 			if (ControlBlock != nullptr)
 			{
-				ControlBlock->WeakCounter++;
+				ThreadPolicy::Increment(ControlBlock->WeakCounter);
 			}
 		}
 		return *this;
 	}
 
-	WeakPointer<T>& operator=(WeakPointer<T>&& other) noexcept
+	WeakPointer<T, ThreadPolicy>& operator=(WeakPointer<T, ThreadPolicy>&& other) noexcept
 	{
 		if (this != &other)
 		{
@@ -204,19 +785,15 @@ public:
 		return *this;
 	}
 
-	SharedPointer<T> Lock() const
+	SharedPointer<T, ThreadPolicy> Lock() const
 	{
-		if (IsExpired())
-		{
-			return SharedPointer<T>();
-		}
-
-		return SharedPointer<T>(*this);
+		// Checking IsExpired() first and copying afterwards would race with the last owner going away
+		return SharedPointer<T, ThreadPolicy>(*this);
 	}
 
 	bool IsExpired() const
 	{
-		return ControlBlock == nullptr || ControlBlock->SharedCounter == 0;
+		return ControlBlock == nullptr || ThreadPolicy::Load(ControlBlock->SharedCounter) == 0;
 	}
 
 private:
@@ -224,66 +801,353 @@ private:
 	{
 		if (ControlBlock != nullptr)
 		{
-			if (--ControlBlock->WeakCounter == 0)
-			{
-				if (ControlBlock->SharedCounter == 0)
-				{
-					delete ControlBlock;
-					ControlBlock = nullptr;
-				}
-			}
+			ControlBlock->ReleaseWeak();
+			Pointer = nullptr;
+			ControlBlock = nullptr;
 		}
 	}
 
 
-	WeakPointer(T* InPointer, ControlStruct* InControlBlock)
+	WeakPointer(ElementType* InPointer, ControlStruct<ThreadPolicy>* InControlBlock)
 		: Pointer(InPointer)
 		, ControlBlock(InControlBlock)
 	{}
 
 private:
-	T* Pointer;
-	ControlStruct* ControlBlock;
+	ElementType* Pointer;
+	ControlStruct<ThreadPolicy>* ControlBlock;
+
+	friend class SharedPointer<T, ThreadPolicy>;
 
-	friend class SharedPointer<T>;
+	template<typename U, typename P>
+	friend class EnableSharedFromThis;
 };
 
-template<typename T>
-class UniquePointer
+// Creates the object and its control block with a single allocation from InAllocator
+template<typename T, typename ThreadPolicy, typename Allocator, typename... ArgTypes>
+SharedPointer<T, ThreadPolicy> AllocateShared(const Allocator& InAllocator, ArgTypes&&... Args)
 {
-public:
-	UniquePointer(T* InPointer = nullptr)
-		: Pointer(InPointer)
-	{}
+	auto* ControlBlock = CreateControlBlock<InPlaceControlStruct<T, Allocator, ThreadPolicy>>(
+		InAllocator, InAllocator, std::forward<ArgTypes>(Args)...);
+	AttachSharedFromThis(ControlBlock->GetObject(), ControlBlock);
+	Statistics::RecordAllocation<T>(*ControlBlock);
+	return SharedPointer<T, ThreadPolicy>(
+		typename SharedPointer<T, ThreadPolicy>::AdoptReference(), ControlBlock->GetObject(), ControlBlock);
+}
+
+// Creates the object and its control block with a single allocation
+template<typename T, typename ThreadPolicy, typename... ArgTypes>
+SharedPointer<T, ThreadPolicy> MakeShared(ArgTypes&&... Args)
+{
+	return AllocateShared<T, ThreadPolicy>(std::allocator<T>(), std::forward<ArgTypes>(Args)...);
+}
+
+// Base for objects that need to hand out SharedPointers to themselves (like std::enable_shared_from_this).
+// SharedPointer and MakeShared remember the control block here when they take the object over. It is a plain
+// pointer rather than a WeakPointer: the block always outlives the object, so no weak reference is needed.
+template<typename T, typename ThreadPolicy>
+class EnableSharedFromThis
+{
+public:
+	// Empty if the object is not owned by a SharedPointer (yet or anymore)
+	SharedPointer<T, ThreadPolicy> SharedFromThis()
+	{
+		if (OwnerControlBlock == nullptr || !ThreadPolicy::IncrementIfNotZero(OwnerControlBlock->SharedCounter))
+		{
+			return SharedPointer<T, ThreadPolicy>();
+		}
+		return SharedPointer<T, ThreadPolicy>(
+			typename SharedPointer<T, ThreadPolicy>::AdoptReference(), static_cast<T*>(this), OwnerControlBlock);
+	}
+
+	SharedPointer<const T, ThreadPolicy> SharedFromThis() const
+	{
+		if (OwnerControlBlock == nullptr || !ThreadPolicy::IncrementIfNotZero(OwnerControlBlock->SharedCounter))
+		{
+			return SharedPointer<const T, ThreadPolicy>();
+		}
+		return SharedPointer<const T, ThreadPolicy>(
+			typename SharedPointer<const T, ThreadPolicy>::AdoptReference(), static_cast<const T*>(this), OwnerControlBlock);
+	}
+
+	WeakPointer<T, ThreadPolicy> WeakFromThis()
+	{
+		if (OwnerControlBlock == nullptr)
+		{
+			return WeakPointer<T, ThreadPolicy>();
+		}
+		ThreadPolicy::Increment(OwnerControlBlock->WeakCounter);
+		return WeakPointer<T, ThreadPolicy>(static_cast<T*>(this), OwnerControlBlock);
+	}
+
+protected:
+	EnableSharedFromThis() : OwnerControlBlock(nullptr) {}
+
+	// A copy is a different object, it gets its own owners
+	EnableSharedFromThis(const EnableSharedFromThis&) : OwnerControlBlock(nullptr) {}
+	EnableSharedFromThis& operator=(const EnableSharedFromThis&) { return *this; }
+
+	~EnableSharedFromThis() = default;
+
+private:
+	mutable ControlStruct<ThreadPolicy>* OwnerControlBlock;
+
+	template<typename U, typename ObjectPolicy, typename P>
+	friend void AttachSharedFromThis(const EnableSharedFromThis<U, ObjectPolicy>* Object, ControlStruct<P>* InControlBlock);
+};
+
+// Casts share the control block of InPointer, nothing is allocated
+template<typename T, typename U, typename ThreadPolicy>
+SharedPointer<T, ThreadPolicy> StaticPointerCast(const SharedPointer<U, ThreadPolicy>& InPointer)
+{
+	return SharedPointer<T, ThreadPolicy>(InPointer, static_cast<typename SharedPointer<T, ThreadPolicy>::ElementType*>(InPointer.Get()));
+}
+
+// Empty if the object is not a T
+template<typename T, typename U, typename ThreadPolicy>
+SharedPointer<T, ThreadPolicy> DynamicPointerCast(const SharedPointer<U, ThreadPolicy>& InPointer)
+{
+	if (auto* Casted = dynamic_cast<typename SharedPointer<T, ThreadPolicy>::ElementType*>(InPointer.Get()))
+	{
+		return SharedPointer<T, ThreadPolicy>(InPointer, Casted);
+	}
+	return SharedPointer<T, ThreadPolicy>();
+}
+
+template<typename T, typename U, typename ThreadPolicy>
+SharedPointer<T, ThreadPolicy> ConstPointerCast(const SharedPointer<U, ThreadPolicy>& InPointer)
+{
+	return SharedPointer<T, ThreadPolicy>(InPointer, const_cast<typename SharedPointer<T, ThreadPolicy>::ElementType*>(InPointer.Get()));
+}
+
+template<typename T>
+using ThreadSafeSharedPointer = SharedPointer<T, MultiThreadPolicy>;
+
+template<typename T>
+using ThreadSafeWeakPointer = WeakPointer<T, MultiThreadPolicy>;
+
+// ThreadSafeSharedPointer that can be loaded and replaced from many threads at once without a lock.
+//
+// Every stored value lives in a Snapshot node. State packs the node address together with an external counter:
+// a reader borrows the node with one fetch_add, copies the SharedPointer out of it and gives the borrow back
+// with a compare-exchange. A writer swaps the whole State, so the borrows still outstanding at that moment move
+// to the internal counter of the old node, which is deleted once all of them have been given back
+// ("split reference counting"). Neither side ever blocks or waits for the other.
+template<typename T>
+class AtomicSharedPointer
+{
+public:
+	using PointerType = ThreadSafeSharedPointer<T>;
+
+	AtomicSharedPointer()
+		: State(0)
+	{}
+
+	explicit AtomicSharedPointer(PointerType InValue)
+		: State(Pack(CreateSnapshot(std::move(InValue))))
+	{}
+
+	~AtomicSharedPointer()
+	{
+		ReleaseSnapshot(State.load(std::memory_order_acquire));
+	}
+
+	AtomicSharedPointer(const AtomicSharedPointer<T>&) = delete;
+	AtomicSharedPointer<T>& operator=(const AtomicSharedPointer<T>&) = delete;
+
+	PointerType Load() const
+	{
+		const std::uint64_t Current = State.fetch_add(OneExternal, std::memory_order_acquire);
+		Snapshot* Borrowed = GetSnapshot(Current);
+
+		PointerType Result;
+		if (Borrowed != nullptr)
+		{
+			Result = Borrowed->Value;
+		}
+		ReturnBorrow(Borrowed);
+		return Result;
+	}
+
+	void Store(PointerType InValue)
+	{
+		Exchange(std::move(InValue));
+	}
+
+	PointerType Exchange(PointerType InValue)
+	{
+		const std::uint64_t Previous = State.exchange(Pack(CreateSnapshot(std::move(InValue))), std::memory_order_acq_rel);
+		return ReleaseSnapshot(Previous);
+	}
+
+	// Replaces the value with Desired if it still points to the same object as Expected,
+	// otherwise loads the current value into Expected
+	bool CompareExchange(PointerType& Expected, PointerType Desired)
+	{
+		Snapshot* Replacement = nullptr;
+		while (true)
+		{
+			std::uint64_t Current = State.fetch_add(OneExternal, std::memory_order_acquire) + OneExternal;
+			Snapshot* Borrowed = GetSnapshot(Current);
+
+			const PointerType& Value = Borrowed != nullptr ? Borrowed->Value : EmptyValue();
+			if (Value.Get() != Expected.Get() || Value.ControlBlock != Expected.ControlBlock)
+			{
+				Expected = Value;
+				ReturnBorrow(Borrowed);
+				delete Replacement;
+				return false;
+			}
+
+			if (Replacement == nullptr)
+			{
+				Replacement = CreateSnapshot(std::move(Desired));
+			}
+
+			// Other readers may borrow and return the node meanwhile, only a new node makes us start over
+			while (GetSnapshot(Current) == Borrowed && GetExternalCount(Current) > 0)
+			{
+				if (State.compare_exchange_weak(Current, Pack(Replacement), std::memory_order_acq_rel, std::memory_order_relaxed))
+				{
+					// Our own borrow goes away together with the node, the others move to its internal counter
+					ReleaseInternal(Borrowed, GetExternalCount(Current) - 1);
+					return true;
+				}
+			}
+
+			ReturnBorrow(Borrowed);
+		}
+	}
+
+	bool IsLockFree() const { return State.is_lock_free(); }
+
+private:
+	struct Snapshot
+	{
+		explicit Snapshot(PointerType InValue)
+			: InternalCounter(0)
+			, Value(std::move(InValue))
+		{}
+
+		// Borrows handed over by the writer that replaced this node minus the ones given back since
+		std::atomic<int> InternalCounter;
+		const PointerType Value;
+	};
+
+	// Node addresses fit into the lower 48 bits on 64-bit platforms, the rest counts the borrows
+	static constexpr int PointerBits = sizeof(void*) == 8 ? 48 : 32;
+	static constexpr std::uint64_t OneExternal = std::uint64_t(1) << PointerBits;
+	static constexpr std::uint64_t PointerMask = OneExternal - 1;
+
+	static std::uint64_t Pack(Snapshot* InSnapshot)
+	{
+		const std::uint64_t Address = reinterpret_cast<std::uintptr_t>(InSnapshot);
+		assert((Address & ~PointerMask) == 0);
+		return Address;
+	}
+
+	static Snapshot* GetSnapshot(std::uint64_t InState)
+	{
+		return reinterpret_cast<Snapshot*>(static_cast<std::uintptr_t>(InState & PointerMask));
+	}
+
+	static int GetExternalCount(std::uint64_t InState)
+	{
+		return static_cast<int>(InState >> PointerBits);
+	}
+
+	static Snapshot* CreateSnapshot(PointerType InValue)
+	{
+		return InValue.ControlBlock != nullptr ? new Snapshot(std::move(InValue)) : nullptr;
+	}
+
+	static const PointerType& EmptyValue()
+	{
+		static const PointerType Empty;
+		return Empty;
+	}
+
+	static void ReleaseInternal(Snapshot* InSnapshot, int Delta)
+	{
+		if (InSnapshot != nullptr && InSnapshot->InternalCounter.fetch_add(Delta, std::memory_order_acq_rel) + Delta == 0)
+		{
+			delete InSnapshot;
+		}
+	}
+
+	// Called by whoever took Previous out of State: moves the outstanding borrows to the old node
+	static PointerType ReleaseSnapshot(std::uint64_t Previous)
+	{
+		Snapshot* OldSnapshot = GetSnapshot(Previous);
+		if (OldSnapshot == nullptr)
+		{
+			return PointerType();
+		}
+
+		PointerType OldValue = OldSnapshot->Value;
+		ReleaseInternal(OldSnapshot, GetExternalCount(Previous));
+		return OldValue;
+	}
+
+	void ReturnBorrow(Snapshot* Borrowed) const
+	{
+		std::uint64_t Current = State.load(std::memory_order_relaxed);
+		while (GetSnapshot(Current) == Borrowed && GetExternalCount(Current) > 0)
+		{
+			if (State.compare_exchange_weak(Current, Current - OneExternal, std::memory_order_acq_rel, std::memory_order_relaxed))
+			{
+				return;
+			}
+		}
+
+		// The node was replaced and our borrow was moved to its internal counter
+		ReleaseInternal(Borrowed, -1);
+	}
+
+	mutable std::atomic<std::uint64_t> State;
+};
+
+// The deleter is a part of the type, so a stateless one costs no space
+template<typename T, typename Deleter>
+class UniquePointer : private EmptyBaseStorage<Deleter>
+{
+public:
+	UniquePointer(T* InPointer = nullptr)
+		: Pointer(InPointer)
+	{}
+
+	UniquePointer(T* InPointer, Deleter InDeleter)
+		: EmptyBaseStorage<Deleter>(std::move(InDeleter))
+		, Pointer(InPointer)
+	{}
 
 	~UniquePointer()
 	{
-		delete Pointer;
+		Reset();
 	}
 
-	UniquePointer(UniquePointer<T>&& Other) noexcept
+	UniquePointer(UniquePointer<T, Deleter>&& Other) noexcept
+		: EmptyBaseStorage<Deleter>(std::move(Other.GetDeleter()))
 	{
 		Pointer = Other.Pointer;
 
 		Other.Pointer = nullptr;
 	}
 
-	UniquePointer<T>& operator=(UniquePointer<T>&& Other) noexcept
+	UniquePointer<T, Deleter>& operator=(UniquePointer<T, Deleter>&& Other) noexcept
 	{
 		if (this != &Other)
 		{
-			delete Pointer;
+			Reset(Other.Release());
 
-			Pointer = Other.Pointer;
-
-			Other.Pointer = nullptr;
+			GetDeleter() = std::move(Other.GetDeleter());
 		}
 
 		return *this;
 	}
 
-	UniquePointer(const UniquePointer<T>& other) = delete;
-	UniquePointer<T> operator=(const UniquePointer<T>& other) = delete;
+	UniquePointer(const UniquePointer<T, Deleter>& other) = delete;
+	UniquePointer<T, Deleter> operator=(const UniquePointer<T, Deleter>& other) = delete;
 
 	T* operator->() const
 	{
@@ -304,8 +1168,12 @@ public:
 
 	void Reset(T* NewPointer = nullptr)
 	{
-		delete Pointer;
+		T* OldPointer = Pointer;
 		Pointer = NewPointer;
+		if (OldPointer != nullptr)
+		{
+			GetDeleter()(OldPointer);
+		}
 	}
 
 	T* Get() const
@@ -313,108 +1181,466 @@ public:
 		return Pointer;
 	}
 
+	Deleter& GetDeleter() { return EmptyBaseStorage<Deleter>::Get(); }
+	const Deleter& GetDeleter() const { return EmptyBaseStorage<Deleter>::Get(); }
+
 private:
 	T* Pointer;
 };
 
-void TestSharedPointer()
+// Array version: indexing instead of -> and *, delete[] through DefaultDelete<T[]>
+template<typename T, typename Deleter>
+class UniquePointer<T[], Deleter> : private EmptyBaseStorage<Deleter>
 {
-	// Test constructor
-	SharedPointer<int> sp1(new int(10));
-	assert(*sp1 == 10);
-	assert(sp1.UseCount() == 1);
+public:
+	UniquePointer(T* InPointer = nullptr)
+		: Pointer(InPointer)
+	{}
 
-	// Test copy constructor
-	SharedPointer<int> sp2(sp1);
-	assert(sp1.UseCount() == 2);
-	assert(sp2.UseCount() == 2);
-	assert(*sp2 == 10);
+	UniquePointer(T* InPointer, Deleter InDeleter)
+		: EmptyBaseStorage<Deleter>(std::move(InDeleter))
+		, Pointer(InPointer)
+	{}
 
-	// Test move constructor
-	SharedPointer<int> sp3(std::move(sp2));
-	assert(sp1.UseCount() == 2);
-	assert(sp2.UseCount() == 0);
-	assert(sp3.UseCount() == 2);
-	assert(*sp3 == 10);
-	assert(sp2.Get() == nullptr);
+	~UniquePointer()
+	{
+		Reset();
+	}
 
-	// Test copy assignment operator
-	SharedPointer<int> sp4;
-	sp4 = sp1;
-	assert(sp1.UseCount() == 3);
-	assert(sp4.UseCount() == 3);
-	assert(*sp4 == 10);
+	UniquePointer(UniquePointer<T[], Deleter>&& Other) noexcept
+		: EmptyBaseStorage<Deleter>(std::move(Other.GetDeleter()))
+	{
+		Pointer = Other.Pointer;
 
-	// Test move assignment operator
-	SharedPointer<int> sp5;
-	sp5 = std::move(sp3);
-	assert(sp1.UseCount() == 3);
-	assert(sp3.UseCount() == 0);
-	assert(sp5.UseCount() == 3);
-	assert(*sp5 == 10);
-	assert(sp3.Get() == nullptr);
+		Other.Pointer = nullptr;
+	}
 
-	// Test dereference and member access operators
+	UniquePointer<T[], Deleter>& operator=(UniquePointer<T[], Deleter>&& Other) noexcept
 	{
-		struct TestStruct1
+		if (this != &Other)
 		{
-			int data = 172;
+			Reset(Other.Release());
 
-			void foo()
-			{
-				std::cout << "foo called" << std::endl;
-			}
-		};
+			GetDeleter() = std::move(Other.GetDeleter());
+		}
 
-		SharedPointer<TestStruct1> sp6(new TestStruct1());
-		assert((*sp6).data == 172);
-		assert(sp6->data == 172);
+		return *this;
 	}
 
-	// Test destructor
+	UniquePointer(const UniquePointer<T[], Deleter>& other) = delete;
+	UniquePointer<T[], Deleter> operator=(const UniquePointer<T[], Deleter>& other) = delete;
+
+	T& operator[](std::size_t Index) const
 	{
-		SharedPointer<int> sp7(new int(30));
-		assert(sp7.UseCount() == 1);
-	} // sp7 goes out of scope here and should properly release resources
+		return Pointer[Index];
+	}
 
-	// Edge case: Empty SharedPointer
-	SharedPointer<int> sp8;
-	assert(sp8.Get() == nullptr);
-	assert(sp8.UseCount() == 0);
+	T* Release()
+	{
+		T* OldPointer = Pointer;
+		Pointer = nullptr;
+		return OldPointer;
+	}
 
-	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
-}
+	void Reset(T* NewPointer = nullptr)
+	{
+		T* OldPointer = Pointer;
+		Pointer = NewPointer;
+		if (OldPointer != nullptr)
+		{
+			GetDeleter()(OldPointer);
+		}
+	}
 
-void TestWeakPointer()
-{
-	// Default constructor
-	WeakPointer<int> wp1;
-	assert(wp1.IsExpired());
+	T* Get() const
+	{
+		return Pointer;
+	}
 
-	// Constructor with SharedPointer
-	SharedPointer<int> sp1(new int(20));
-	WeakPointer<int> wp2(sp1);
-	assert(!wp2.IsExpired());
+	Deleter& GetDeleter() { return EmptyBaseStorage<Deleter>::Get(); }
+	const Deleter& GetDeleter() const { return EmptyBaseStorage<Deleter>::Get(); }
 
-	// Copy constructor
-	WeakPointer<int> wp3 = wp2;
-	assert(!wp3.IsExpired());
+private:
+	T* Pointer;
+};
 
-	// Move constructor
-	WeakPointer<int> wp4 = std::move(wp3);
-	assert(!wp4.IsExpired());
-	assert(wp3.IsExpired());
+template<typename T, typename... ArgTypes>
+std::enable_if_t<!std::is_array<T>::value, UniquePointer<T>> MakeUnique(ArgTypes&&... Args)
+{
+	return UniquePointer<T>(new T(std::forward<ArgTypes>(Args)...));
+}
 
-	// Copy assignment operator
-	WeakPointer<int> wp5;
-	wp5 = wp2;
-	assert(!wp5.IsExpired());
+// Elements are value-initialized, i.e. zeroed for trivial types
+template<typename T>
+std::enable_if_t<std::is_array<T>::value && std::extent<T>::value == 0, UniquePointer<T>> MakeUnique(std::size_t Count)
+{
+	return UniquePointer<T>(new std::remove_extent_t<T>[Count]());
+}
 
-	// Move assignment operator
-	WeakPointer<int> wp6;
-	wp6 = std::move(wp5);
-	assert(!wp6.IsExpired());
-	assert(wp5.IsExpired());
+// Default-initialized: trivial types are left as they are, for memory that is about to be overwritten anyway
+template<typename T>
+std::enable_if_t<!std::is_array<T>::value, UniquePointer<T>> MakeUniqueForOverwrite()
+{
+	return UniquePointer<T>(new T);
+}
+
+template<typename T>
+std::enable_if_t<std::is_array<T>::value && std::extent<T>::value == 0, UniquePointer<T>> MakeUniqueForOverwrite(std::size_t Count)
+{
+	return UniquePointer<T>(new std::remove_extent_t<T>[Count]);
+}
+
+// Base for objects that keep their reference count inside themselves (CRTP),
+// so IntrusivePointer needs neither a control block nor a second pointer
+template<typename Derived, typename ThreadPolicy = SingleThreadPolicy>
+class RefCounted
+{
+public:
+	void AddReference() const
+	{
+		ThreadPolicy::Increment(ReferenceCounter);
+	}
+
+	void ReleaseReference() const
+	{
+		if (ThreadPolicy::Decrement(ReferenceCounter))
+		{
+			delete static_cast<const Derived*>(this);
+		}
+	}
+
+	// Gives up the last reference without destroying the object, e.g. to hand it over to a UniquePointer
+	void DetachLastReference() const
+	{
+		assert(ThreadPolicy::Load(ReferenceCounter) == 1);
+		ThreadPolicy::Decrement(ReferenceCounter);
+	}
+
+	int GetReferenceCount() const { return ThreadPolicy::Load(ReferenceCounter); }
+
+protected:
+	RefCounted() : ReferenceCounter(0) {}
+
+	// A copy is a new object with its own owners
+	RefCounted(const RefCounted&) : ReferenceCounter(0) {}
+	RefCounted& operator=(const RefCounted&) { return *this; }
+
+	~RefCounted() = default;
+
+private:
+	mutable typename ThreadPolicy::CounterType ReferenceCounter;
+};
+
+template<typename Derived>
+using ThreadSafeRefCounted = RefCounted<Derived, MultiThreadPolicy>;
+
+// Works with any T that has AddReference()/ReleaseReference(), usually through RefCounted
+template<typename T>
+class IntrusivePointer
+{
+public:
+	IntrusivePointer(T* InPointer = nullptr)
+		: Pointer(InPointer)
+	{
+		if (Pointer != nullptr)
+		{
+			Pointer->AddReference();
+		}
+	}
+
+	// Takes the object over from a UniquePointer
+	IntrusivePointer(UniquePointer<T>&& InUniquePointer)
+		: IntrusivePointer(InUniquePointer.Release())
+	{}
+
+	IntrusivePointer(const IntrusivePointer<T>& other)
+		: IntrusivePointer(other.Pointer)
+	{}
+
+	IntrusivePointer(IntrusivePointer<T>&& other) noexcept
+		: Pointer(other.Pointer)
+	{
+		other.Pointer = nullptr;
+	}
+
+	~IntrusivePointer()
+	{
+		Reset();
+	}
+
+	IntrusivePointer<T>& operator=(const IntrusivePointer<T>& other)
+	{
+		if (this != &other)
+		{
+			Reset(other.Pointer);
+		}
+		return *this;
+	}
+
+	IntrusivePointer<T>& operator=(IntrusivePointer<T>&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Reset();
+
+			Pointer = other.Pointer;
+			other.Pointer = nullptr;
+		}
+		return *this;
+	}
+
+	T* operator->() const
+	{
+		return Pointer;
+	}
+
+	T& operator*() const
+	{
+		return *Pointer;
+	}
+
+	T* Get() const { return Pointer; }
+
+	int UseCount() const { return Pointer != nullptr ? Pointer->GetReferenceCount() : 0; }
+
+	void Reset(T* NewPointer = nullptr)
+	{
+		if (NewPointer != nullptr)
+		{
+			NewPointer->AddReference();
+		}
+
+		T* OldPointer = Pointer;
+		Pointer = NewPointer;
+		if (OldPointer != nullptr)
+		{
+			OldPointer->ReleaseReference();
+		}
+	}
+
+	// Hands the object over to a UniquePointer, only valid while this is the only owner
+	UniquePointer<T> ReleaseUnique()
+	{
+		T* OldPointer = Pointer;
+		Pointer = nullptr;
+		if (OldPointer != nullptr)
+		{
+			OldPointer->DetachLastReference();
+		}
+		return UniquePointer<T>(OldPointer);
+	}
+
+private:
+	T* Pointer;
+};
+
+// Fixed-size block pool with an intrusive free list, e.g. to keep control blocks out of the general heap.
+// Not thread-safe; every block has the size of the largest type the pool was created for.
+class BlockPool
+{
+public:
+	BlockPool(std::size_t InBlockSize, std::size_t InBlocksPerChunk = 256)
+		: BlockSize(RoundUp(std::max(InBlockSize, sizeof(FreeBlock))))
+		, BlocksPerChunk(InBlocksPerChunk)
+		, FreeList(nullptr)
+	{}
+
+	~BlockPool()
+	{
+		for (unsigned char* Chunk : Chunks)
+		{
+			::operator delete(Chunk, std::align_val_t(alignof(std::max_align_t)));
+		}
+	}
+
+	BlockPool(const BlockPool&) = delete;
+	BlockPool& operator=(const BlockPool&) = delete;
+
+	void* Allocate([[maybe_unused]] std::size_t Size)
+	{
+		assert(Size <= BlockSize);
+		if (FreeList == nullptr)
+		{
+			AddChunk();
+		}
+
+		FreeBlock* Block = FreeList;
+		FreeList = Block->Next;
+		return Block;
+	}
+
+	void Deallocate(void* Block)
+	{
+		FreeBlock* Freed = static_cast<FreeBlock*>(Block);
+		Freed->Next = FreeList;
+		FreeList = Freed;
+	}
+
+private:
+	struct FreeBlock
+	{
+		FreeBlock* Next;
+	};
+
+	static std::size_t RoundUp(std::size_t Size)
+	{
+		const std::size_t Alignment = alignof(std::max_align_t);
+		return (Size + Alignment - 1) / Alignment * Alignment;
+	}
+
+	void AddChunk()
+	{
+		auto* Chunk = static_cast<unsigned char*>(
+			::operator new(BlockSize * BlocksPerChunk, std::align_val_t(alignof(std::max_align_t))));
+		Chunks.push_back(Chunk);
+
+		for (std::size_t i = 0; i < BlocksPerChunk; ++i)
+		{
+			Deallocate(Chunk + i * BlockSize);
+		}
+	}
+
+	std::size_t BlockSize;
+	std::size_t BlocksPerChunk;
+	FreeBlock* FreeList;
+	std::vector<unsigned char*> Chunks;
+};
+
+// Standard allocator interface on top of a BlockPool, for AllocateShared and SharedPointer(Pointer, Deleter, Allocator)
+template<typename T>
+class PoolAllocator
+{
+public:
+	using value_type = T;
+
+	explicit PoolAllocator(BlockPool& InPool) : Pool(&InPool) {}
+
+	template<typename U>
+	PoolAllocator(const PoolAllocator<U>& Other) : Pool(Other.Pool) {}
+
+	T* allocate(std::size_t Count)
+	{
+		assert(Count == 1);
+		static_assert(alignof(T) <= alignof(std::max_align_t), "BlockPool does not support over-aligned types");
+		return static_cast<T*>(Pool->Allocate(sizeof(T) * Count));
+	}
+
+	void deallocate(T* InPointer, std::size_t)
+	{
+		Pool->Deallocate(InPointer);
+	}
+
+	template<typename U>
+	bool operator==(const PoolAllocator<U>& Other) const { return Pool == Other.Pool; }
+
+	template<typename U>
+	bool operator!=(const PoolAllocator<U>& Other) const { return Pool != Other.Pool; }
+
+private:
+	BlockPool* Pool;
+
+	template<typename U>
+	friend class PoolAllocator;
+};
+
+void TestSharedPointer()
+{
+	// Test constructor
+	SharedPointer<int> sp1(new int(10));
+	assert(*sp1 == 10);
+	assert(sp1.UseCount() == 1);
+
+	// Test copy constructor
+	SharedPointer<int> sp2(sp1);
+	assert(sp1.UseCount() == 2);
+	assert(sp2.UseCount() == 2);
+	assert(*sp2 == 10);
+
+	// Test move constructor
+	SharedPointer<int> sp3(std::move(sp2));
+	assert(sp1.UseCount() == 2);
+	assert(sp2.UseCount() == 0);
+	assert(sp3.UseCount() == 2);
+	assert(*sp3 == 10);
+	assert(sp2.Get() == nullptr);
+
+	// Test copy assignment operator
+	SharedPointer<int> sp4;
+	sp4 = sp1;
+	assert(sp1.UseCount() == 3);
+	assert(sp4.UseCount() == 3);
+	assert(*sp4 == 10);
+
+	// Test move assignment operator
+	SharedPointer<int> sp5;
+	sp5 = std::move(sp3);
+	assert(sp1.UseCount() == 3);
+	assert(sp3.UseCount() == 0);
+	assert(sp5.UseCount() == 3);
+	assert(*sp5 == 10);
+	assert(sp3.Get() == nullptr);
+
+	// Test dereference and member access operators
+	{
+		struct TestStruct1
+		{
+			int data = 172;
+
+			void foo()
+			{
+				std::cout << "foo called" << std::endl;
+			}
+		};
+
+		SharedPointer<TestStruct1> sp6(new TestStruct1());
+		assert((*sp6).data == 172);
+		assert(sp6->data == 172);
+	}
+
+	// Test destructor
+	{
+		SharedPointer<int> sp7(new int(30));
+		assert(sp7.UseCount() == 1);
+	} // sp7 goes out of scope here and should properly release resources
+
+	// Edge case: Empty SharedPointer
+	SharedPointer<int> sp8;
+	assert(sp8.Get() == nullptr);
+	assert(sp8.UseCount() == 0);
+
+	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+void TestWeakPointer()
+{
+	// Default constructor
+	WeakPointer<int> wp1;
+	assert(wp1.IsExpired());
+
+	// Constructor with SharedPointer
+	SharedPointer<int> sp1(new int(20));
+	WeakPointer<int> wp2(sp1);
+	assert(!wp2.IsExpired());
+
+	// Copy constructor
+	WeakPointer<int> wp3 = wp2;
+	assert(!wp3.IsExpired());
+
+	// Move constructor
+	WeakPointer<int> wp4 = std::move(wp3);
+	assert(!wp4.IsExpired());
+	assert(wp3.IsExpired());
+
+	// Copy assignment operator
+	WeakPointer<int> wp5;
+	wp5 = wp2;
+	assert(!wp5.IsExpired());
+
+	// Move assignment operator
+	WeakPointer<int> wp6;
+	wp6 = std::move(wp5);
+	assert(!wp6.IsExpired());
+	assert(wp5.IsExpired());
 
 	// Lock to get SharedPointer
 	SharedPointer<int> sp2 = wp2.Lock();
@@ -422,9 +1648,9 @@ void TestWeakPointer()
 	assert(*sp2 == 20);
 
 	// Expire the WeakPointer
-	sp2.~SharedPointer();
+	sp2 = SharedPointer<int>();
 	assert(!wp2.IsExpired());
-	sp1.~SharedPointer();
+	sp1 = SharedPointer<int>();
 	assert(wp2.IsExpired());
 
 	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
@@ -497,12 +1723,989 @@ void TestUniquePointer()
 	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
 }
 
-void TestSmartPointers()
+void TestThreadSafeSharedPointer()
 {
-	TestSharedPointer();
-	TestWeakPointer();
-	TestCycleReferencing();
+	struct Tracked
+	{
+		std::atomic<int>* Destructions;
+		explicit Tracked(std::atomic<int>* InDestructions) : Destructions(InDestructions) {}
+		~Tracked() { Destructions->fetch_add(1); }
+	};
+
+	std::atomic<int> destructions(0);
+	{
+		ThreadSafeSharedPointer<Tracked> sp1(new Tracked(&destructions));
+		ThreadSafeWeakPointer<Tracked> wp1(sp1);
+
+		// Copy and destroy from several threads at once
+		std::vector<std::thread> threads;
+		for (int i = 0; i < 4; ++i)
+		{
+			threads.emplace_back([&sp1, &wp1]()
+				{
+					for (int j = 0; j < 10000; ++j)
+					{
+						ThreadSafeSharedPointer<Tracked> copy(sp1);
+						ThreadSafeSharedPointer<Tracked> locked = wp1.Lock();
+						assert(locked.Get() == sp1.Get());
+					}
+				});
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		assert(sp1.UseCount() == 1);
+		assert(destructions == 0);
+	}
+	assert(destructions == 1);
+
+	// Lock() racing with the last owner either gets the object or nothing, never a dangling pointer
+	for (int i = 0; i < 100; ++i)
+	{
+		ThreadSafeSharedPointer<Tracked> sp2(new Tracked(&destructions));
+		ThreadSafeWeakPointer<Tracked> wp2(sp2);
+
+		std::thread locker([&wp2]()
+			{
+				ThreadSafeSharedPointer<Tracked> locked = wp2.Lock();
+				assert(locked.Get() == nullptr || locked.UseCount() >= 1);
+			});
+		sp2 = ThreadSafeSharedPointer<Tracked>();
+		locker.join();
+
+		assert(wp2.IsExpired());
+		assert(wp2.Lock().Get() == nullptr);
+	}
+	assert(destructions == 101);
+
+	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+void TestMakeShared()
+{
+	struct Tracked
+	{
+		int Value;
+		int* Destructions;
+		Tracked(int InValue, int* InDestructions) : Value(InValue), Destructions(InDestructions) {}
+		~Tracked() { ++(*Destructions); }
+	};
+
+	int destructions = 0;
+
+	// Object and counters share one allocation
+	SharedPointer<Tracked> sp1 = MakeShared<Tracked>(42, &destructions);
+	assert(sp1->Value == 42);
+	assert(sp1.UseCount() == 1);
+
+	SharedPointer<Tracked> sp2(sp1);
+	assert(sp2.UseCount() == 2);
+
+	// The object dies with the last SharedPointer even if a WeakPointer keeps the block alive
+	WeakPointer<Tracked> wp1(sp1);
+	sp1 = SharedPointer<Tracked>();
+	sp2 = SharedPointer<Tracked>();
+	assert(destructions == 1);
+	assert(wp1.IsExpired());
+	assert(wp1.Lock().Get() == nullptr);
+
+	// Over-aligned types keep their alignment inside the control block
+	struct alignas(64) Aligned
+	{
+		char Data[64];
+	};
+	SharedPointer<Aligned> sp3 = MakeShared<Aligned>();
+	assert(reinterpret_cast<std::uintptr_t>(sp3.Get()) % alignof(Aligned) == 0);
+
+	ThreadSafeSharedPointer<int> sp4 = MakeShared<int, MultiThreadPolicy>(7);
+	assert(*sp4 == 7);
+
+	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+void TestCustomDeleters()
+{
+	// Objects go back to the deleter instead of the global heap
+	int deletions = 0;
+	auto countingDeleter = [&deletions](int* InPointer)
+		{
+			++deletions;
+			delete InPointer;
+		};
+
+	{
+		SharedPointer<int> sp1(new int(1), countingDeleter);
+		SharedPointer<int> sp2(sp1);
+		assert(sp2.UseCount() == 2);
+	}
+	assert(deletions == 1);
+
+	{
+		UniquePointer<int, decltype(countingDeleter)> up1(new int(2), countingDeleter);
+		UniquePointer<int, decltype(countingDeleter)> up2(std::move(up1));
+		assert(up1.Get() == nullptr);
+		up2.Reset(new int(3));
+		assert(deletions == 2);
+	}
+	assert(deletions == 3);
+
+	// Stateless deleters cost nothing, stateful ones are stored next to the pointer
+	struct StatelessDeleter
+	{
+		void operator()(int* InPointer) const { delete InPointer; }
+	};
+	static_assert(sizeof(UniquePointer<int>) == sizeof(int*), "DefaultDelete must not take space");
+	static_assert(sizeof(UniquePointer<int, StatelessDeleter>) == sizeof(int*), "Empty deleters must not take space");
+	static_assert(sizeof(UniquePointer<int, decltype(countingDeleter)>) > sizeof(int*), "Stateful deleters are stored");
+
+	// Control blocks from a pool
+	BlockPool pool(64);
+	PoolAllocator<int> allocator(pool);
+	{
+		SharedPointer<int> sp3 = AllocateShared<int>(allocator, 4);
+		assert(*sp3 == 4);
+		WeakPointer<int> wp1(sp3);
+		sp3 = SharedPointer<int>();
+		assert(wp1.IsExpired());
+
+		SharedPointer<int> sp4(new int(5), countingDeleter, allocator);
+		assert(*sp4 == 5);
+	}
+	assert(deletions == 4);
+
+	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+void TestIntrusivePointer()
+{
+	struct Node : public RefCounted<Node>
+	{
+		int Value;
+		int* Destructions;
+		Node(int InValue, int* InDestructions) : Value(InValue), Destructions(InDestructions) {}
+		~Node() { ++(*Destructions); }
+	};
+
+	int destructions = 0;
+	{
+		IntrusivePointer<Node> ip1(new Node(1, &destructions));
+		assert(ip1.UseCount() == 1);
+
+		// The count lives in the object, so a raw pointer can be turned into another owner
+		IntrusivePointer<Node> ip2(ip1.Get());
+		assert(ip1.UseCount() == 2);
+
+		IntrusivePointer<Node> ip3(std::move(ip2));
+		assert(ip2.Get() == nullptr);
+		assert(ip3.UseCount() == 2);
+
+		ip3 = ip1;
+		assert(ip1.UseCount() == 2);
+		assert(ip3->Value == 1);
+	}
+	assert(destructions == 1);
+
+	// Round trip through UniquePointer
+	{
+		UniquePointer<Node> up1(new Node(2, &destructions));
+		IntrusivePointer<Node> ip4(std::move(up1));
+		assert(up1.Get() == nullptr);
+		assert(ip4.UseCount() == 1);
+
+		UniquePointer<Node> up2 = ip4.ReleaseUnique();
+		assert(ip4.Get() == nullptr);
+		assert(up2->Value == 2);
+		assert(up2->GetReferenceCount() == 0);
+		assert(destructions == 1);
+	}
+	assert(destructions == 2);
+
+	// Atomic variant shared between threads
+	struct SharedNode : public ThreadSafeRefCounted<SharedNode>
+	{
+		std::atomic<int>* Destructions;
+		explicit SharedNode(std::atomic<int>* InDestructions) : Destructions(InDestructions) {}
+		~SharedNode() { Destructions->fetch_add(1); }
+	};
+
+	std::atomic<int> sharedDestructions(0);
+	{
+		IntrusivePointer<SharedNode> ip5(new SharedNode(&sharedDestructions));
+		std::vector<std::thread> threads;
+		for (int i = 0; i < 4; ++i)
+		{
+			threads.emplace_back([&ip5]()
+				{
+					for (int j = 0; j < 10000; ++j)
+					{
+						IntrusivePointer<SharedNode> copy(ip5);
+					}
+				});
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		assert(ip5.UseCount() == 1);
+	}
+	assert(sharedDestructions == 1);
+
+	static_assert(sizeof(IntrusivePointer<Node>) == sizeof(Node*), "IntrusivePointer is a single pointer");
+
+	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+void TestAtomicSharedPointer()
+{
+	struct Config
+	{
+		int Version;
+		int Checksum;
+		std::atomic<int>* Destructions;
+		Config(int InVersion, std::atomic<int>* InConstructions, std::atomic<int>* InDestructions)
+			: Version(InVersion), Checksum(InVersion * 2), Destructions(InDestructions)
+		{
+			InConstructions->fetch_add(1);
+		}
+		~Config() { Destructions->fetch_add(1); }
+	};
+
+	std::atomic<int> constructions(0);
+	std::atomic<int> destructions(0);
+	{
+		AtomicSharedPointer<Config> current;
+		assert(current.Load().Get() == nullptr);
+
+		current.Store(MakeShared<Config, MultiThreadPolicy>(0, &constructions, &destructions));
+		assert(current.Load()->Version == 0);
+
+		// Readers always see a complete snapshot while the writer keeps publishing new ones
+		const int versions = 2000;
+		std::atomic<bool> done(false);
+		std::vector<std::thread> readers;
+		for (int i = 0; i < 4; ++i)
+		{
+			readers.emplace_back([&current, &done]()
+				{
+					[[maybe_unused]] int lastVersion = 0;
+					while (!done.load())
+					{
+						ThreadSafeSharedPointer<Config> snapshot = current.Load();
+						assert(snapshot->Checksum == snapshot->Version * 2);
+						assert(snapshot->Version >= lastVersion);
+						lastVersion = snapshot->Version;
+					}
+				});
+		}
+
+		for (int version = 1; version <= versions; ++version)
+		{
+			current.Store(MakeShared<Config, MultiThreadPolicy>(version, &constructions, &destructions));
+		}
+		done = true;
+		for (std::thread& reader : readers)
+		{
+			reader.join();
+		}
+		assert(current.Load()->Version == versions);
+		assert(destructions == versions);
+
+		// Concurrent read-modify-write through CompareExchange loses no update. A failed exchange
+		// destroys the Config it was given, so how many are created depends on the contention.
+		std::vector<std::thread> writers;
+		for (int i = 0; i < 4; ++i)
+		{
+			writers.emplace_back([&current, &constructions, &destructions]()
+				{
+					for (int j = 0; j < 500; ++j)
+					{
+						ThreadSafeSharedPointer<Config> expected = current.Load();
+						while (!current.CompareExchange(expected,
+							MakeShared<Config, MultiThreadPolicy>(expected->Version + 1, &constructions, &destructions)))
+						{
+						}
+					}
+				});
+		}
+		for (std::thread& writer : writers)
+		{
+			writer.join();
+		}
+		assert(current.Load()->Version == versions + 2000);
+
+		ThreadSafeSharedPointer<Config> previous = current.Exchange(ThreadSafeSharedPointer<Config>());
+		assert(previous->Version == versions + 2000);
+		assert(current.Load().Get() == nullptr);
+	}
+	assert(constructions >= 4001);
+	assert(destructions == constructions);
+
+	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+void TestArrayPointers()
+{
+	struct Tracked
+	{
+		static int& Destructions() { static int Count = 0; return Count; }
+		int Value = 5;
+		~Tracked() { ++Destructions(); }
+	};
+
+	// delete[] runs every destructor
+	{
+		UniquePointer<Tracked[]> up1(new Tracked[3]);
+		assert(up1[2].Value == 5);
+
+		UniquePointer<Tracked[]> up2(std::move(up1));
+		assert(up1.Get() == nullptr);
+		up2.Reset(new Tracked[2]);
+		assert(Tracked::Destructions() == 3);
+	}
+	assert(Tracked::Destructions() == 5);
+
+	{
+		SharedPointer<Tracked[]> sp1(new Tracked[4]);
+		SharedPointer<Tracked[]> sp2(sp1);
+		sp2[1].Value = 7;
+		assert(sp1[1].Value == 7);
+		assert(sp1.UseCount() == 2);
+
+		WeakPointer<Tracked[]> wp1(sp1);
+		assert(wp1.Lock()[1].Value == 7);
+	}
+	assert(Tracked::Destructions() == 9);
+
+	// Value-initialized versus left for overwriting
+	UniquePointer<int[]> zeroed = MakeUnique<int[]>(16);
+	for (std::size_t i = 0; i < 16; ++i)
+	{
+		assert(zeroed[i] == 0);
+	}
+
+	UniquePointer<int[]> buffer = MakeUniqueForOverwrite<int[]>(16);
+	for (std::size_t i = 0; i < 16; ++i)
+	{
+		buffer[i] = static_cast<int>(i);
+	}
+	assert(buffer[15] == 15);
+
+	UniquePointer<int> up3 = MakeUnique<int>(3);
+	assert(*up3 == 3);
+
+	static_assert(sizeof(UniquePointer<int[]>) == sizeof(int*), "DefaultDelete<T[]> must not take space");
+
+	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+void TestPointerCasts()
+{
+	struct Base
+	{
+		int BaseValue = 1;
+		virtual ~Base() = default;
+	};
+
+	struct Derived : public Base
+	{
+		int DerivedValue = 2;
+		int* Destructions = nullptr;
+		~Derived() override { ++(*Destructions); }
+	};
+
+	struct Other : public Base
+	{
+	};
+
+	int destructions = 0;
+	{
+		SharedPointer<Derived> derived = MakeShared<Derived>();
+		derived->Destructions = &destructions;
+
+		// Derived to base shares the control block
+		SharedPointer<Base> base(derived);
+		assert(base.Get() == derived.Get());
+		assert(derived.UseCount() == 2);
+
+		SharedPointer<Base> movedBase{SharedPointer<Derived>(derived)};
+		assert(derived.UseCount() == 3);
+		movedBase = SharedPointer<Base>();
+
+		WeakPointer<Base> weakBase(derived);
+		assert(weakBase.Lock().Get() == base.Get());
+
+		SharedPointer<Derived> downcast = StaticPointerCast<Derived>(base);
+		assert(downcast->DerivedValue == 2);
+		assert(derived.UseCount() == 3);
+
+		SharedPointer<Derived> checked = DynamicPointerCast<Derived>(base);
+		assert(checked.Get() == derived.Get());
+		assert(DynamicPointerCast<Other>(base).Get() == nullptr);
+
+		SharedPointer<const Derived> constDerived(derived);
+		SharedPointer<Derived> mutableDerived = ConstPointerCast<Derived>(constDerived);
+		assert(mutableDerived.Get() == derived.Get());
+
+		// A pointer to a member keeps the whole object alive
+		SharedPointer<int> member(derived, &derived->DerivedValue);
+		derived = SharedPointer<Derived>();
+		base = SharedPointer<Base>();
+		downcast = SharedPointer<Derived>();
+		checked = SharedPointer<Derived>();
+		constDerived = SharedPointer<const Derived>();
+		mutableDerived = SharedPointer<Derived>();
+		assert(destructions == 0);
+		assert(*member == 2);
+		assert(member.UseCount() == 1);
+	}
+	assert(destructions == 1);
+
+	// Without a virtual destructor the object is still destroyed as the type it was created with
+	struct PlainBase
+	{
+	};
+	struct PlainDerived : public PlainBase
+	{
+		int* Destructions;
+		explicit PlainDerived(int* InDestructions) : Destructions(InDestructions) {}
+		~PlainDerived() { ++(*Destructions); }
+	};
+	{
+		SharedPointer<PlainBase> plainBase(SharedPointer<PlainDerived>(new PlainDerived(&destructions)));
+	}
+	assert(destructions == 2);
+
+	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+void TestEnableSharedFromThis()
+{
+	// The same shape as Decorator::Notification: a virtual method that returns an owner of this
+	class Notification : public EnableSharedFromThis<Notification>
+	{
+	public:
+		virtual ~Notification() = default;
+		virtual SharedPointer<Notification> Self() { return SharedFromThis(); }
+	};
+
+	class EmailNotification : public Notification
+	{
+	};
+
+	{
+		SharedPointer<Notification> sp1(new EmailNotification());
+		SharedPointer<Notification> sp2 = sp1->Self();
+		assert(sp2.Get() == sp1.Get());
+		assert(sp1.UseCount() == 2);
+
+		WeakPointer<Notification> wp1 = sp1->WeakFromThis();
+		assert(!wp1.IsExpired());
+
+		const Notification& constNotification = *sp1;
+		SharedPointer<const Notification> sp3 = constNotification.SharedFromThis();
+		assert(sp1.UseCount() == 3);
+
+		sp1 = SharedPointer<Notification>();
+		sp2 = SharedPointer<Notification>();
+		sp3 = SharedPointer<const Notification>();
+		assert(wp1.IsExpired());
+	}
+
+	// MakeShared hooks in as well
+	{
+		SharedPointer<Notification> sp4 = MakeShared<Notification>();
+		assert(sp4->Self().Get() == sp4.Get());
+		assert(sp4.UseCount() == 1);
+
+		// Converting to a base does not re-attach
+		SharedPointer<EmailNotification> sp5 = MakeShared<EmailNotification>();
+		SharedPointer<Notification> sp6(sp5);
+		assert(sp6->Self().Get() == sp5.Get());
+	}
+
+	// Not owned by any SharedPointer
+	{
+		Notification local;
+		assert(local.Self().Get() == nullptr);
+		assert(local.WeakFromThis().IsExpired());
+	}
+
+	// Thread-safe variant
+	struct Shared : public EnableSharedFromThis<Shared, MultiThreadPolicy>
+	{
+	};
+	ThreadSafeSharedPointer<Shared> sp7 = MakeShared<Shared, MultiThreadPolicy>();
+	assert(sp7->SharedFromThis().Get() == sp7.Get());
+
+	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+void TestStatistics()
+{
+	struct Tracked
+	{
+		int Value = 0;
+	};
+
+	Statistics::Reset();
+	{
+		SharedPointer<Tracked> sp1(new Tracked());
+		SharedPointer<Tracked> sp2 = MakeShared<Tracked>();
+		SharedPointer<Tracked> sp3(sp1);
+		SharedPointer<Tracked> sp4(std::move(sp3));
+
+		WeakPointer<Tracked> wp1(sp2);
+		assert(wp1.Lock().Get() == sp2.Get());
+		sp2 = SharedPointer<Tracked>();
+		assert(wp1.Lock().Get() == nullptr);
+	}
+
+	if constexpr (Statistics::Enabled)
+	{
+		[[maybe_unused]] const Statistics::TypeCounters& Counters = Statistics::CountersFor<Tracked>();
+		assert(Counters.Allocations == 2);
+		assert(Counters.Copies == 1);
+		assert(Counters.Moves >= 1);
+		assert(Counters.WeakLocks == 2);
+		assert(Counters.FailedWeakLocks == 1);
+		assert(Counters.Destructions == 2);
+		assert(Counters.Live == 0);
+		assert(Counters.PeakLive == 2);
+
+		std::ostringstream Out;
+		Statistics::Dump(Out);
+		assert(Out.str().find("smart_pointers_allocations_total{type=\"") != std::string::npos);
+	}
+
+	std::cout << __FUNCTION__ << " : All tests passed!" << std::endl;
+}
+
+void TestSmartPointers()
+{
+	TestSharedPointer();
+	TestWeakPointer();
+	TestCycleReferencing();
 	TestUniquePointer();
+	TestThreadSafeSharedPointer();
+	TestMakeShared();
+	TestCustomDeleters();
+	TestIntrusivePointer();
+	TestAtomicSharedPointer();
+	TestArrayPointers();
+	TestPointerCasts();
+	TestEnableSharedFromThis();
+	TestStatistics();
+}
+
+// Copy + destroy of a SharedPointer that all threads share (one contended counter)
+// versus one SharedPointer per thread (no sharing, shows the raw cost of the atomic instructions)
+void BenchmarkSharedPointerContention()
+{
+	const std::size_t Iterations = 1000000;
+
+	{
+		SharedPointer<int> source(new int(1));
+		Benchmark::Run("SharedPointer<SingleThreadPolicy> copy/destroy", Iterations, [&source](std::size_t Count)
+			{
+				for (std::size_t i = 0; i < Count; ++i)
+				{
+					SharedPointer<int> copy(source);
+					Benchmark::DoNotOptimize(copy);
+				}
+			});
+	}
+
+	for (int threads : Benchmark::ThreadCounts())
+	{
+		ThreadSafeSharedPointer<int> source(new int(1));
+		Benchmark::RunParallel("SharedPointer<MultiThreadPolicy> copy/destroy shared", threads, Iterations,
+			[&source](int, std::size_t Count)
+			{
+				for (std::size_t i = 0; i < Count; ++i)
+				{
+					ThreadSafeSharedPointer<int> copy(source);
+					Benchmark::DoNotOptimize(copy);
+				}
+			});
+	}
+
+	for (int threads : Benchmark::ThreadCounts())
+	{
+		Benchmark::RunParallel("SharedPointer<MultiThreadPolicy> copy/destroy per thread", threads, Iterations,
+			[](int, std::size_t Count)
+			{
+				ThreadSafeSharedPointer<int> source(new int(1));
+				for (std::size_t i = 0; i < Count; ++i)
+				{
+					ThreadSafeSharedPointer<int> copy(source);
+					Benchmark::DoNotOptimize(copy);
+				}
+			});
+	}
+}
+
+// SharedPointer<T>(new T) allocates the object and the control block separately, MakeShared does one allocation
+void BenchmarkMakeShared()
+{
+	struct Payload
+	{
+		int Values[4] = {};
+	};
+
+	const std::size_t Iterations = 1000000;
+
+	Benchmark::Run("SharedPointer(new T) create/destroy", Iterations, [](std::size_t Count)
+		{
+			for (std::size_t i = 0; i < Count; ++i)
+			{
+				SharedPointer<Payload> pointer(new Payload());
+				Benchmark::DoNotOptimize(pointer);
+			}
+		});
+
+	Benchmark::Run("MakeShared<T>() create/destroy", Iterations, [](std::size_t Count)
+		{
+			for (std::size_t i = 0; i < Count; ++i)
+			{
+				SharedPointer<Payload> pointer = MakeShared<Payload>();
+				Benchmark::DoNotOptimize(pointer);
+			}
+		});
+
+	BlockPool pool(128);
+	PoolAllocator<Payload> allocator(pool);
+	Benchmark::Run("AllocateShared<T>(PoolAllocator) create/destroy", Iterations, [&allocator](std::size_t Count)
+		{
+			for (std::size_t i = 0; i < Count; ++i)
+			{
+				SharedPointer<Payload> pointer = AllocateShared<Payload>(allocator);
+				Benchmark::DoNotOptimize(pointer);
+			}
+		});
+}
+
+// Walks a linked list with an owning cursor. SharedPointer touches a separate control block on every step,
+// IntrusivePointer finds the count in the node it has to load anyway.
+template<typename NodePointer, typename MakeNodeFunc>
+void BenchmarkListWalk(const std::string& Name, MakeNodeFunc MakeNode)
+{
+	const std::size_t Nodes = 100000;
+	const std::size_t Walks = 20;
+
+	NodePointer head = MakeNode();
+	NodePointer tail = head;
+	for (std::size_t i = 1; i < Nodes; ++i)
+	{
+		tail->Next = MakeNode();
+		tail = tail->Next;
+	}
+	tail = NodePointer();
+
+	Benchmark::Run(Name, Nodes * Walks, [&head](std::size_t Count)
+		{
+			std::size_t sum = 0;
+			for (std::size_t step = 0; step < Count;)
+			{
+				for (NodePointer current = head; current.Get() != nullptr && step < Count; current = current->Next, ++step)
+				{
+					sum += current->Value;
+				}
+			}
+			Benchmark::DoNotOptimize(sum);
+		});
+
+	// Unlink iteratively, a recursive destruction of a long list would overflow the stack
+	while (head.Get() != nullptr)
+	{
+		NodePointer next = head->Next;
+		head->Next = NodePointer();
+		head = next;
+	}
+}
+
+void BenchmarkIntrusivePointer()
+{
+	struct SharedNode
+	{
+		SharedPointer<SharedNode> Next;
+		std::size_t Value = 1;
+	};
+
+	struct IntrusiveNode : public RefCounted<IntrusiveNode>
+	{
+		IntrusivePointer<IntrusiveNode> Next;
+		std::size_t Value = 1;
+	};
+
+	BenchmarkListWalk<SharedPointer<SharedNode>>("SharedPointer(new T) list walk",
+		[]() { return SharedPointer<SharedNode>(new SharedNode()); });
+	BenchmarkListWalk<SharedPointer<SharedNode>>("MakeShared<T>() list walk",
+		[]() { return MakeShared<SharedNode>(); });
+	BenchmarkListWalk<IntrusivePointer<IntrusiveNode>>("IntrusivePointer list walk",
+		[]() { return IntrusivePointer<IntrusiveNode>(new IntrusiveNode()); });
+}
+
+// Reader-heavy publishing: thread 0 stores a new snapshot every 1024 operations, everything else is a Load()
+void BenchmarkAtomicSharedPointer()
+{
+	const std::size_t Iterations = 1000000;
+	const std::size_t StoreInterval = 1024;
+
+	for (int threads : Benchmark::ThreadCounts())
+	{
+		AtomicSharedPointer<int> current(MakeShared<int, MultiThreadPolicy>(0));
+		Benchmark::RunParallel("AtomicSharedPointer Load/Store", threads, Iterations,
+			[&current, StoreInterval](int ThreadIndex, std::size_t Count)
+			{
+				for (std::size_t i = 0; i < Count; ++i)
+				{
+					if (ThreadIndex == 0 && i % StoreInterval == 0)
+					{
+						current.Store(MakeShared<int, MultiThreadPolicy>(static_cast<int>(i)));
+					}
+					else
+					{
+						ThreadSafeSharedPointer<int> snapshot = current.Load();
+						Benchmark::DoNotOptimize(snapshot);
+					}
+				}
+			});
+	}
+
+	for (int threads : Benchmark::ThreadCounts())
+	{
+		std::mutex mutex;
+		ThreadSafeSharedPointer<int> current = MakeShared<int, MultiThreadPolicy>(0);
+		Benchmark::RunParallel("std::mutex + SharedPointer Load/Store", threads, Iterations,
+			[&current, &mutex, StoreInterval](int ThreadIndex, std::size_t Count)
+			{
+				for (std::size_t i = 0; i < Count; ++i)
+				{
+					if (ThreadIndex == 0 && i % StoreInterval == 0)
+					{
+						ThreadSafeSharedPointer<int> next = MakeShared<int, MultiThreadPolicy>(static_cast<int>(i));
+						std::lock_guard<std::mutex> lock(mutex);
+						current = next;
+					}
+					else
+					{
+						ThreadSafeSharedPointer<int> snapshot;
+						{
+							std::lock_guard<std::mutex> lock(mutex);
+							snapshot = current;
+						}
+						Benchmark::DoNotOptimize(snapshot);
+					}
+				}
+			});
+	}
+}
+
+// Allocating a large buffer and filling it: value-initialization writes every byte twice
+void BenchmarkMakeUniqueForOverwrite()
+{
+	const std::size_t Elements = 4 * 1024 * 1024;
+	const std::size_t Buffers = 20;
+
+	Benchmark::Run("MakeUnique<T[]>(n) + fill, bytes", Buffers * Elements * sizeof(int), [Elements](std::size_t Count)
+		{
+			for (std::size_t i = 0; i < Count / (Elements * sizeof(int)); ++i)
+			{
+				UniquePointer<int[]> buffer = MakeUnique<int[]>(Elements);
+				for (std::size_t j = 0; j < Elements; ++j)
+				{
+					buffer[j] = static_cast<int>(j);
+				}
+				Benchmark::DoNotOptimize(buffer[Elements - 1]);
+			}
+		});
+
+	Benchmark::Run("MakeUniqueForOverwrite<T[]>(n) + fill, bytes", Buffers * Elements * sizeof(int), [Elements](std::size_t Count)
+		{
+			for (std::size_t i = 0; i < Count / (Elements * sizeof(int)); ++i)
+			{
+				UniquePointer<int[]> buffer = MakeUniqueForOverwrite<int[]>(Elements);
+				for (std::size_t j = 0; j < Elements; ++j)
+				{
+					buffer[j] = static_cast<int>(j);
+				}
+				Benchmark::DoNotOptimize(buffer[Elements - 1]);
+			}
+		});
+}
+
+// Adapters that let one benchmark body drive our pointers and the standard ones.
+// std::shared_ptr always counts atomically, so it is compared against both of our thread policies.
+template<typename ThreadPolicy>
+struct CustomPointers
+{
+	static constexpr bool ThreadSafe = std::is_same<ThreadPolicy, MultiThreadPolicy>::value;
+
+	template<typename T> using Shared = SharedPointer<T, ThreadPolicy>;
+	template<typename T> using Weak = WeakPointer<T, ThreadPolicy>;
+	template<typename T> using Unique = UniquePointer<T>;
+
+	template<typename T> static Shared<T> MakeSharedObject() { return MakeShared<T, ThreadPolicy>(); }
+	template<typename T> static Unique<T> MakeUniqueObject() { return MakeUnique<T>(); }
+	template<typename T> static Shared<T> Lock(const Weak<T>& Pointer) { return Pointer.Lock(); }
+};
+
+struct StandardPointers
+{
+	static constexpr bool ThreadSafe = true;
+
+	template<typename T> using Shared = std::shared_ptr<T>;
+	template<typename T> using Weak = std::weak_ptr<T>;
+	template<typename T> using Unique = std::unique_ptr<T>;
+
+	template<typename T> static Shared<T> MakeSharedObject() { return std::make_shared<T>(); }
+	template<typename T> static Unique<T> MakeUniqueObject() { return std::make_unique<T>(); }
+	template<typename T> static Shared<T> Lock(const Weak<T>& Pointer) { return Pointer.lock(); }
+};
+
+// Construction, copy, move, Lock() and destruction timed one at a time, then a multithreaded mix of all of them.
+// Every pointer an operation produces is kept alive in a vector, so only that operation is measured.
+template<typename Pointers>
+void BenchmarkPointerOperations(const std::string& Prefix)
+{
+	struct Payload
+	{
+		int Values[4] = {};
+	};
+
+	using Shared = typename Pointers::template Shared<Payload>;
+	using Weak = typename Pointers::template Weak<Payload>;
+	using Unique = typename Pointers::template Unique<Payload>;
+
+	const std::size_t Iterations = 1000000;
+
+	std::vector<Shared> sharedPointers;
+	std::vector<Shared> otherSharedPointers;
+	std::vector<Unique> uniquePointers;
+	const Shared source = Pointers::template MakeSharedObject<Payload>();
+	const Weak weakSource(source);
+
+	auto prepareEmpty = [&](std::size_t Count)
+		{
+			sharedPointers.clear();
+			sharedPointers.resize(Count);
+		};
+
+	Benchmark::RunWithSetup(Prefix + " shared construct(new T)", Iterations, prepareEmpty, [&](std::size_t Count)
+		{
+			for (std::size_t i = 0; i < Count; ++i)
+			{
+				sharedPointers[i] = Shared(new Payload());
+			}
+		});
+
+	Benchmark::RunWithSetup(Prefix + " shared construct(make)", Iterations, prepareEmpty, [&](std::size_t Count)
+		{
+			for (std::size_t i = 0; i < Count; ++i)
+			{
+				sharedPointers[i] = Pointers::template MakeSharedObject<Payload>();
+			}
+		});
+
+	Benchmark::Run(Prefix + " shared destroy", Iterations, [&](std::size_t)
+		{
+			sharedPointers.clear();
+		});
+
+	Benchmark::RunWithSetup(Prefix + " shared copy", Iterations, prepareEmpty, [&](std::size_t Count)
+		{
+			for (std::size_t i = 0; i < Count; ++i)
+			{
+				sharedPointers[i] = source;
+			}
+		});
+
+	Benchmark::RunWithSetup(Prefix + " shared move", Iterations,
+		[&](std::size_t Count)
+		{
+			otherSharedPointers.clear();
+			otherSharedPointers.resize(Count);
+		},
+		[&](std::size_t Count)
+		{
+			for (std::size_t i = 0; i < Count; ++i)
+			{
+				otherSharedPointers[i] = std::move(sharedPointers[i]);
+			}
+		});
+
+	Benchmark::RunWithSetup(Prefix + " weak Lock()", Iterations, prepareEmpty, [&](std::size_t Count)
+		{
+			for (std::size_t i = 0; i < Count; ++i)
+			{
+				sharedPointers[i] = Pointers::Lock(weakSource);
+			}
+		});
+
+	Benchmark::Run(Prefix + " shared release copy", Iterations, [&](std::size_t)
+		{
+			sharedPointers.clear();
+		});
+	otherSharedPointers.clear();
+
+	Benchmark::RunWithSetup(Prefix + " unique construct(make)", Iterations,
+		[&](std::size_t Count)
+		{
+			uniquePointers.clear();
+			uniquePointers.reserve(Count);
+		},
+		[&](std::size_t Count)
+		{
+			for (std::size_t i = 0; i < Count; ++i)
+			{
+				uniquePointers.push_back(Pointers::template MakeUniqueObject<Payload>());
+			}
+		});
+
+	Benchmark::Run(Prefix + " unique destroy", Iterations, [&](std::size_t)
+		{
+			uniquePointers.clear();
+		});
+
+	if constexpr (Pointers::ThreadSafe)
+	{
+		// Churn: copy the shared object, lock it through a weak pointer and create and drop a private one
+		for (int threads : Benchmark::ThreadCounts())
+		{
+			Benchmark::RunParallel(Prefix + " churn", threads, Iterations / 4,
+				[&source, &weakSource](int, std::size_t Count)
+				{
+					for (std::size_t i = 0; i < Count; ++i)
+					{
+						Shared copy(source);
+						Shared locked = Pointers::Lock(weakSource);
+						Shared own = Pointers::template MakeSharedObject<Payload>();
+						Benchmark::DoNotOptimize(copy);
+						Benchmark::DoNotOptimize(locked);
+						Benchmark::DoNotOptimize(own);
+					}
+				});
+		}
+	}
+}
+
+void BenchmarkAgainstStandard()
+{
+	BenchmarkPointerOperations<CustomPointers<SingleThreadPolicy>>("SmartPointers<SingleThreadPolicy>");
+	BenchmarkPointerOperations<CustomPointers<MultiThreadPolicy>>("SmartPointers<MultiThreadPolicy>");
+	BenchmarkPointerOperations<StandardPointers>("std");
+}
+
+void BenchmarkSmartPointers()
+{
+	BenchmarkAgainstStandard();
+	BenchmarkSharedPointerContention();
+	BenchmarkMakeShared();
+	BenchmarkIntrusivePointer();
+	BenchmarkAtomicSharedPointer();
+	BenchmarkMakeUniqueForOverwrite();
 }
 
 } // namespace SmartPointers